@@ -0,0 +1,655 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <sstream>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <experimental/filesystem>
+#include "transforms.hpp"
+#include "utils.hpp"
+
+using std::cout;
+using std::string;
+using std::vector;
+
+
+/*heap allocations of the program (operator new and Eigen both allocate with malloc), counted by
+  interposing malloc in front of the C library's when possible*/
+static std::atomic<long> allocations(0);
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+
+extern "C" void *malloc(size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+static const bool allocationsCounted = true;
+#else
+static const bool allocationsCounted = false;
+#endif
+
+
+/**
+ * @brief Best wall time of several runs of a function.
+ *
+ * @param f Function to time
+ * @param reps Number of runs
+ * @return double Best time in milliseconds
+ */
+static double bestTimeMs(const std::function<void()>& f, int reps = 5) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+
+/**
+ * @brief Column pass of a 2D FFT (512 rows): strided columns vs cache-blocked transpose and contiguous rows.
+ * Single-threaded, so that only the memory access pattern differs.
+ */
+static void benchTranspose() {
+    const int nrows = 512;
+    cout << "== FFT2D column pass, " << nrows << " rows, 1 thread ==\n";
+    cout << std::setw(8) << "width" << std::setw(14) << "strided ms" << std::setw(14) << "blocked ms"
+         << std::setw(10) << "speedup" << "\n";
+
+    auto plan = FFTPlan<float>::get(nrows, -1);
+    for (int width = 256; width <= 8192; width *= 2) {
+        std::vector<std::complex<float>> data(size_t(nrows) * width);
+        for (size_t k = 0; k < data.size(); ++k) {
+            data[k] = std::complex<float>(k % 251, 0);
+        }
+        std::vector<std::complex<float>> columns(data.size());
+        std::vector<std::complex<float>> buffer(nrows);
+
+        double strided = bestTimeMs([&] {
+            for (int j = 0; j < width; ++j) {
+                plan->execute(data.data() + j, width, buffer.data());
+            }
+        });
+        double blocked = bestTimeMs([&] {
+            transposeBlocked(data.data(), columns.data(), nrows, width, 0, width);
+            for (int j = 0; j < width; ++j) {
+                plan->execute(columns.data() + size_t(j) * nrows);
+            }
+            transposeBlocked(columns.data(), data.data(), width, nrows, 0, nrows);
+        });
+        cout << std::setw(8) << width << std::fixed << std::setprecision(2)
+             << std::setw(14) << strided << std::setw(14) << blocked
+             << std::setw(9) << strided / blocked << "x\n";
+    }
+}
+
+
+/**
+ * @brief Plan setup with measurement (cold run) vs from the wisdom (warm run), and transform time
+ * of the estimated vs the measured plans, for power-of-two, mixed radix and prime sizes.
+ */
+static void benchWisdom() {
+    cout << "== FFT plans: tuning vs wisdom, float ==\n";
+    cout << std::setw(8) << "size" << std::setw(12) << "tune ms" << std::setw(12) << "wisdom ms"
+         << std::setw(16) << "estimated us" << std::setw(14) << "tuned us" << "\n";
+
+    for (int n : {1024, 65536, 6720, 100800, 10007}) {
+        FFTPlanChoice tuned;
+        double tune = bestTimeMs([&] {
+            tuned = FFTPlan<float>::measure(n, -1);
+            FFTPlan<float> plan(n, -1, tuned);
+        }, 1);
+        FFTWisdom::record(n, -1, "float", tuned);
+        double load = bestTimeMs([&] {
+            FFTPlanChoice choice;
+            FFTWisdom::lookup(n, -1, "float", choice);
+            FFTPlan<float> plan(n, -1, choice);
+        });
+
+        std::vector<std::complex<float>> data(n, std::complex<float>(1, 0));
+        FFTPlan<float> estimatedPlan(n, -1);
+        FFTPlan<float> tunedPlan(n, -1, tuned);
+        double estimated = bestTimeMs([&] { estimatedPlan.execute(data.data()); }, 20) * 1000;
+        double measured = bestTimeMs([&] { tunedPlan.execute(data.data()); }, 20) * 1000;
+        cout << std::setw(8) << n << std::fixed << std::setprecision(2)
+             << std::setw(12) << tune << std::setw(12) << load
+             << std::setw(16) << estimated << std::setw(14) << measured << "\n";
+    }
+    FFTWisdom::clear();
+}
+
+
+/**
+ * @brief Row FFTs of a matrix: one FFT1D object per row vs one BatchFFT1D call.
+ */
+static void benchBatch() {
+    cout << "== row FFTs: FFT1D per row vs BatchFFT1D, double ==\n";
+    cout << std::setw(12) << "size" << std::setw(14) << "FFT1D ms" << std::setw(14) << "batch ms"
+         << std::setw(10) << "speedup" << "\n";
+
+    for (int n : {256, 1024, 4096}) {
+        MatrixXi item(n, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                item(i, j) = (i * 31 + j * 17) % 256;
+            }
+        }
+        double single = bestTimeMs([&] {
+            ComplexMatrix<double> spectra(n, n);
+            for (int i = 0; i < n; ++i) {
+                FFT1D<> fft;
+                MatrixXi row = item.row(i);
+                spectra.row(i) = fft.transform(row);
+            }
+        }, 3);
+        double batch = bestTimeMs([&] {
+            BatchFFT1D<> fft(FFTAxis::Rows);
+            fft.transform(item);
+        }, 3);
+        cout << std::setw(12) << (std::to_string(n) + "x" + std::to_string(n)) << std::fixed << std::setprecision(2)
+             << std::setw(14) << single << std::setw(14) << batch
+             << std::setw(9) << single / batch << "x\n";
+    }
+}
+
+
+/**
+ * @brief FFT2D and iFFT2D (full spectrum) of the images of a folder with every FFT backend.
+ * The spectra are compared with the in-house backend.
+ *
+ * @param folder Folder with the images
+ */
+static void benchBackends(const string& folder) {
+    vector<string> files;
+    for (const auto &entry : std::experimental::filesystem::directory_iterator(folder)) {
+        files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    vector<MatrixXi> images;
+    for (const auto &file : files) {
+        images.push_back(readIntMatrix(file));
+    }
+
+    cout << "== FFT2D + iFFT2D per backend, double, images from " << folder << " ==\n";
+    vector<string> backends = availableFFTBackends();
+    cout << std::setw(24) << "image";
+    for (const auto &name : backends) {
+        cout << std::setw(12) << (name + " ms");
+    }
+    cout << std::setw(14) << "max error" << "\n";
+
+    for (size_t f = 0; f < files.size(); ++f) {
+        const MatrixXi &image = images[f];
+        ComplexMatrix<double> reference;
+        double error = 0;
+        cout << std::setw(24) << std::experimental::filesystem::path(files[f]).filename().string();
+        for (const auto &name : backends) {
+            setFFTBackend(name);
+            ComplexMatrix<double> freq;
+            double time = bestTimeMs([&] {
+                FFT2D<> fft;
+                iFFT2D<> ifft;
+                freq = fft.transform(image);
+                ifft.transform(freq);
+            }, 3);
+            if (reference.size() == 0) {
+                reference = freq;
+            }
+            error = std::max(error, (freq - reference).cwiseAbs().maxCoeff());
+            cout << std::fixed << std::setprecision(2) << std::setw(12) << time;
+        }
+        cout << std::scientific << std::setprecision(1) << std::setw(14) << error << "\n";
+    }
+    setFFTBackend(backends.front());
+}
+
+
+/**
+ * @brief Cutoff sweep of lowpass filters: one LowpassFilter per cutoff vs one FilterBank.
+ */
+static void benchFilterBank() {
+    cout << "== lowpass sweep of 8 cutoffs: LowpassFilter per cutoff vs FilterBank, double ==\n";
+    cout << std::setw(12) << "size" << std::setw(14) << "filters ms" << std::setw(14) << "bank ms"
+         << std::setw(10) << "speedup" << "\n";
+
+    for (int n : {256, 512, 1024}) {
+        MatrixXi item(n, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                item(i, j) = (i * 31 + j * 17) % 256;
+            }
+        }
+        std::vector<FilterSpec> specs;
+        for (int k = 1; k <= 8; ++k) {
+            specs.push_back(FilterSpec{FilterSpec::IdealLowpass, n * k / 32.});
+        }
+
+        double single = bestTimeMs([&] {
+            for (const auto &spec : specs) {
+                LowpassFilter<> filter(spec.cutoff);
+                filter.transform(item);
+            }
+        }, 3);
+        double bank = bestTimeMs([&] {
+            FilterBank<> filters(specs);
+            filters.transform(item);
+        }, 3);
+        cout << std::setw(12) << (std::to_string(n) + "x" + std::to_string(n)) << std::fixed << std::setprecision(2)
+             << std::setw(14) << single << std::setw(14) << bank
+             << std::setw(9) << single / bank << "x\n";
+    }
+}
+
+
+/**
+ * @brief FFT convolution with cache-sized tiles vs a single tile covering the whole image.
+ */
+static void benchConvolution() {
+    cout << "== 15x15 kernel convolution: one whole-image tile vs L2-sized tiles (FFTConvolution), double ==\n";
+    cout << std::setw(12) << "size" << std::setw(14) << "whole ms" << std::setw(14) << "tiled ms"
+         << std::setw(10) << "speedup" << "\n";
+
+    MatrixXd kernel(15, 15);
+    for (int a = 0; a < 15; ++a) {
+        for (int b = 0; b < 15; ++b) {
+            kernel(a, b) = std::exp(-((a - 7) * (a - 7) + (b - 7) * (b - 7)) / 18.);
+        }
+    }
+    for (int n : {512, 1024, 2048}) {
+        MatrixXi item(n, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                item(i, j) = (i * 31 + j * 17) % 256;
+            }
+        }
+        int whole = 1;
+        while (whole < n + 14) {
+            whole *= 2;
+        }
+        FFTConvolution<> wholeImage(kernel, whole);
+        FFTConvolution<> tiled(kernel);
+        double single = bestTimeMs([&] { wholeImage.transform(item); }, 3);
+        double tiles = bestTimeMs([&] { tiled.transform(item); }, 3);
+        cout << std::setw(12) << (std::to_string(n) + "x" + std::to_string(n)) << std::fixed << std::setprecision(2)
+             << std::setw(14) << single << std::setw(14) << tiles
+             << std::setw(9) << single / tiles << "x\n";
+    }
+}
+
+
+/**
+ * @brief Convolution algorithms (direct, separable, FFT) for several kernel sizes, with the choice of the cost model.
+ */
+static void benchConvolutionMethods() {
+    cout << "== convolution of a 1024x1024 image: direct vs separable vs FFT, and the automatic choice, double ==\n";
+    cout << std::setw(14) << "kernel" << std::setw(12) << "direct ms" << std::setw(14) << "separable ms"
+         << std::setw(10) << "fft ms" << std::setw(12) << "auto" << "\n";
+
+    int n = 1024;
+    MatrixXi item(n, n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            item(i, j) = (i * 31 + j * 17) % 256;
+        }
+    }
+    /*the first large buffers are slower to get from the allocator*/
+    Convolution<>(MatrixXd::Ones(3, 3), ConvolutionMethod::Direct).transform(item);
+    const char *names[] = {"auto", "direct", "separable", "fft"};
+    for (bool gaussian : {true, false}) {
+        for (int k : {3, 5, 9, 15, 25, 41}) {
+            /*a Gaussian is separable, the same with a ripple is not*/
+            MatrixXd kernel(k, k);
+            for (int a = 0; a < k; ++a) {
+                for (int b = 0; b < k; ++b) {
+                    double r2 = (a - k / 2) * (a - k / 2) + (b - k / 2) * (b - k / 2);
+                    kernel(a, b) = std::exp(-r2 / (k * k / 8.)) * (gaussian ? 1. : 1. + 0.1 * std::cos(a * b));
+                }
+            }
+            Convolution<> direct(kernel, ConvolutionMethod::Direct);
+            Convolution<> fft(kernel, ConvolutionMethod::FFT);
+            double directMs = bestTimeMs([&] { direct.transform(item); }, 3);
+            double fftMs = bestTimeMs([&] { fft.transform(item); }, 3);
+            string separableMs = "-";
+            if (gaussian) {
+                Convolution<> separable(kernel, ConvolutionMethod::Separable);
+                std::ostringstream time;
+                time << std::fixed << std::setprecision(2) << bestTimeMs([&] { separable.transform(item); }, 3);
+                separableMs = time.str();
+            }
+            Convolution<> automatic(kernel);
+            cout << std::setw(14) << (std::to_string(k) + "x" + std::to_string(k) + (gaussian ? " sep" : ""))
+                 << std::fixed << std::setprecision(2) << std::setw(12) << directMs << std::setw(14) << separableMs
+                 << std::setw(10) << fftMs << std::setw(12) << names[int(automatic.choose(n, n))] << "\n";
+        }
+    }
+}
+
+
+/**
+ * @brief Heap allocations and time per frame of a stream of same-sized frames: transform(item) vs transform(item, out).
+ */
+static void benchFrames() {
+    cout << "== 512x512 frames: heap allocations and time per frame, returned output vs preallocated output ==\n";
+    if (!allocationsCounted) {
+        cout << "(allocations are only counted with the GNU C library)\n";
+    }
+    cout << std::setw(14) << "transform" << std::setw(14) << "allocs/frame" << std::setw(12) << "ms/frame"
+         << std::setw(14) << "allocs/frame" << std::setw(12) << "ms/frame" << "\n";
+
+    int n = 512;
+    int frames = 20;
+    MatrixXi item(n, n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            item(i, j) = (i * 31 + j * 17) % 256;
+        }
+    }
+    auto row = [&](const string &name, Transform<MatrixXi, MatrixXi> &t, Transform<MatrixXi, MatrixXd> *d,
+                   Transform<MatrixXi, ComplexMatrix<double>> *c) {
+        MatrixXi outInt;
+        MatrixXd outDouble;
+        ComplexMatrix<double> outComplex;
+        double result[4];
+        for (int into = 0; into < 2; ++into) {
+            /*the first frame sets up the plans, masks and scratch buffers*/
+            auto frame = [&] {
+                if (d != nullptr) {
+                    into ? d->transform(item, outDouble) : (void) d->transform(item);
+                } else if (c != nullptr) {
+                    into ? c->transform(item, outComplex) : (void) c->transform(item);
+                } else {
+                    into ? t.transform(item, outInt) : (void) t.transform(item);
+                }
+            };
+            frame();
+            long before = allocations.load();
+            auto start = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; ++f) {
+                frame();
+            }
+            auto end = std::chrono::steady_clock::now();
+            result[2 * into] = double(allocations.load() - before) / frames;
+            result[2 * into + 1] = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+        }
+        cout << std::setw(14) << name << std::fixed << std::setprecision(2)
+             << std::setw(14) << result[0] << std::setw(12) << result[1]
+             << std::setw(14) << result[2] << std::setw(12) << result[3] << "\n";
+    };
+    Thresholding threshold(30, 200);
+    LowpassFilter<> lowpass(n / 8.);
+    FFT2D<> fft;
+    Convolution<> convolution(MatrixXd::Ones(5, 5) / 25.);
+    row("threshold", threshold, nullptr, nullptr);
+    row("fft2D", threshold, nullptr, &fft);
+    row("lowpass", lowpass, nullptr, nullptr);
+    row("convolution", threshold, &convolution, nullptr);
+}
+
+
+/**
+ * @brief Thresholding, histogram and lowpass filter of the same image stored as int, 16-bit and 8-bit pixels.
+ */
+static void benchPixelTypes() {
+    cout << "== 2048x2048 image: ms per transform with int, uint16 and uint8 pixels ==\n";
+    cout << std::setw(12) << "transform" << std::setw(12) << "int" << std::setw(12) << "uint16"
+         << std::setw(12) << "uint8" << "\n";
+    int n = 2048;
+    MatrixXi item(n, n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            item(i, j) = (i * 31 + j * 17) % 256;
+        }
+    }
+    MatrixXu16 item16 = item.cast<uint16_t>();
+    MatrixXu8 item8 = item.cast<uint8_t>();
+    auto row = [&](const string &name, const std::function<void()> &wide, const std::function<void()> &deep,
+                   const std::function<void()> &narrow) {
+        cout << std::setw(12) << name << std::fixed << std::setprecision(2) << std::setw(12) << bestTimeMs(wide)
+             << std::setw(12) << bestTimeMs(deep) << std::setw(12) << bestTimeMs(narrow) << "\n";
+    };
+    MatrixXi outInt;
+    MatrixXu16 out16;
+    MatrixXu8 out8;
+    Thresholding<> threshold(30, 200);
+    Thresholding<uint16_t> threshold16(30, 200);
+    Thresholding<uint8_t> threshold8(30, 200);
+    row("threshold", [&] { threshold.transform(item, outInt); }, [&] { threshold16.transform(item16, out16); },
+        [&] { threshold8.transform(item8, out8); });
+    row("histogram", [&] { Histogram<>().transform(item); }, [&] { Histogram<uint16_t>().transform(item16); },
+        [&] { Histogram<uint8_t>().transform(item8); });
+    LowpassFilter<float> lowpass(n / 8.);
+    LowpassFilter<float, uint16_t> lowpass16(n / 8.);
+    LowpassFilter<float, uint8_t> lowpass8(n / 8.);
+    row("lowpass", [&] { lowpass.transform(item, outInt); }, [&] { lowpass16.transform(item16, out16); },
+        [&] { lowpass8.transform(item8, out8); });
+}
+
+/**
+ * @brief Thresholding bandwidth (bytes read and written per second) with int, uint16 and uint8 pixels:
+ * memcpy of the frame as the baseline, scalar and vector clamp kernels on one thread, then on the pool
+ * out of place and in place.
+ */
+static void benchThreshold() {
+    int n = 4096;
+    cout << "== " << n << "x" << n << " image: thresholding GB/s with int, uint16 and uint8 pixels ("
+         << pixelKernelName() << " kernel, " << ThreadPool::global().size() << " threads) ==\n";
+    cout << std::setw(12) << "method" << std::setw(12) << "int" << std::setw(12) << "uint16"
+         << std::setw(12) << "uint8" << "\n";
+    MatrixXi item(n, n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            item(i, j) = (i * 31 + j * 17) % 256;
+        }
+    }
+    MatrixXu16 item16 = item.cast<uint16_t>();
+    MatrixXu8 item8 = item.cast<uint8_t>();
+    MatrixXi outInt = item;
+    MatrixXu16 out16 = item16;
+    MatrixXu8 out8 = item8;
+    Thresholding<> threshold(30, 200);
+    Thresholding<uint16_t> threshold16(30, 200);
+    Thresholding<uint8_t> threshold8(30, 200);
+
+    /*every method reads and writes the frame once*/
+    double pixels = double(n) * n;
+    auto row = [&](const string &name, const std::function<void()> &wide, const std::function<void()> &deep,
+                   const std::function<void()> &narrow) {
+        cout << std::setw(12) << name << std::fixed << std::setprecision(2)
+             << std::setw(12) << 2 * pixels * sizeof(int) / bestTimeMs(wide) / 1e6
+             << std::setw(12) << 2 * pixels * sizeof(uint16_t) / bestTimeMs(deep) / 1e6
+             << std::setw(12) << 2 * pixels * sizeof(uint8_t) / bestTimeMs(narrow) / 1e6 << "\n";
+    };
+    row("memcpy", [&] { std::memcpy(outInt.data(), item.data(), item.size() * sizeof(int)); },
+        [&] { std::memcpy(out16.data(), item16.data(), item16.size() * sizeof(uint16_t)); },
+        [&] { std::memcpy(out8.data(), item8.data(), item8.size()); });
+
+    string detected = pixelKernelName();
+    int threads = ThreadPool::global().size();
+    ThreadPool::setGlobalThreads(1);
+    setPixelKernel("scalar");
+    row("scalar", [&] { threshold.transform(item, outInt); }, [&] { threshold16.transform(item16, out16); },
+        [&] { threshold8.transform(item8, out8); });
+    setPixelKernel(detected);
+    row("vector", [&] { threshold.transform(item, outInt); }, [&] { threshold16.transform(item16, out16); },
+        [&] { threshold8.transform(item8, out8); });
+    ThreadPool::setGlobalThreads(threads);
+    row("parallel", [&] { threshold.transform(item, outInt); }, [&] { threshold16.transform(item16, out16); },
+        [&] { threshold8.transform(item8, out8); });
+    row("in place", [&] { threshold.transformInPlace(outInt); }, [&] { threshold16.transformInPlace(out16); },
+        [&] { threshold8.transformInPlace(out8); });
+}
+
+/**
+ * @brief Gamma correction and contrast stretch of an 8-bit image: per-pixel arithmetic vs the lookup table
+ * with every lookup kernel supported by the CPU.
+ */
+static void benchLUT() {
+    int n = 4096;
+    cout << "== " << n << "x" << n << " 8-bit image: ms per transform, per-pixel arithmetic vs lookup table ==\n";
+    cout << std::setw(16) << "method" << std::setw(12) << "gamma" << std::setw(12) << "stretch" << "\n";
+    MatrixXu8 item(n, n), out(n, n);
+    for (int k = 0; k < item.size(); ++k) {
+        item(k) = uint8_t((unsigned(k) * 2654435761u) >> 24);
+    }
+    auto row = [&](const string &name, const std::function<void()> &gamma, const std::function<void()> &stretch) {
+        cout << std::setw(16) << name << std::fixed << std::setprecision(2) << std::setw(12) << bestTimeMs(gamma)
+             << std::setw(12) << bestTimeMs(stretch) << "\n";
+    };
+    row("per pixel",
+        [&] { out = item.unaryExpr([](uint8_t v) { return saturatePixel<uint8_t>(255 * std::pow(v / 255., 0.6)); }); },
+        [&] { out = item.unaryExpr([](uint8_t v) { return saturatePixel<uint8_t>((v - 40) * (255. / 160)); }); });
+
+    GammaCorrection gamma(0.6);
+    ContrastStretch stretch(40, 200);
+    string detected = pixelKernelName();
+    vector<string> kernels = availablePixelKernels();
+    for (auto it = kernels.rbegin(); it != kernels.rend(); ++it) {
+        setPixelKernel(*it);
+        row("lut " + *it, [&] { gamma.transform(item, out); }, [&] { stretch.transform(item, out); });
+    }
+    setPixelKernel(detected);
+}
+
+/**
+ * @brief Chain of four pointwise transforms of an 8-bit image (threshold, gamma, contrast stretch, scale):
+ * one transform after the other vs the transforms fused into one table.
+ */
+static void benchFusion() {
+    int n = 4096;
+    cout << "== " << n << "x" << n << " 8-bit image: chain of 4 pointwise transforms ==\n";
+    MatrixXu8 item(n, n), out(n, n), tmp(n, n);
+    for (int k = 0; k < item.size(); ++k) {
+        item(k) = uint8_t((unsigned(k) * 2654435761u) >> 24);
+    }
+    Thresholding<uint8_t> threshold(20, 220);
+    GammaCorrection gamma(0.6);
+    ContrastStretch stretch(40, 200);
+    LUTTransform scale = LUTTransform::fromFunction([](int v) { return 0.8 * v + 10; });
+    LUTTransform fused = threshold.toLUT().then(gamma).then(stretch).then(scale);
+
+    double chained = bestTimeMs([&] {
+        out = scale.transform(stretch.transform(gamma.transform(threshold.transform(item))));
+    });
+    double preallocated = bestTimeMs([&] {
+        threshold.transform(item, tmp);
+        gamma.transformInPlace(tmp);
+        stretch.transformInPlace(tmp);
+        scale.transform(tmp, out);
+    });
+    double single = bestTimeMs([&] { fused.transform(item, out); });
+    cout << std::fixed << std::setprecision(2)
+         << std::setw(28) << "one after the other ms" << std::setw(12) << chained << "\n"
+         << std::setw(28) << "preallocated, in place ms" << std::setw(12) << preallocated << "\n"
+         << std::setw(28) << "fused ms" << std::setw(12) << single << "\n";
+}
+
+/**
+ * @brief Histograms of a 16-bit image with one bin per value vs 256 fixed bins, and level histograms of
+ * float and double audio samples.
+ */
+static void benchBinnedHistogram() {
+    cout << "== histograms: ms per transform and number of bins ==\n";
+    int n = 2048;
+    MatrixXu16 image(n, n);
+    for (int k = 0; k < image.size(); ++k) {
+        image(k) = uint16_t((unsigned(k) * 2654435761u) >> 16);
+    }
+    int samples = 1 << 22;
+    Eigen::MatrixXf audio(1, samples);
+    for (int k = 0; k < samples; ++k) {
+        audio(k) = std::sin(0.001f * k) * std::cos(0.37f * k);
+    }
+    MatrixXd audioDouble = audio.cast<double>();
+    MatrixXd hist;
+    auto row = [&](const string &name, const std::function<void()> &f) {
+        double ms = bestTimeMs(f);
+        cout << std::setw(24) << name << std::fixed << std::setprecision(2) << std::setw(12) << ms
+             << std::setw(10) << hist.cols() << "\n";
+    };
+    row("uint16 one bin per value", [&] { Histogram<uint16_t>().transform(image, hist); });
+    row("uint16 256 bins", [&] { BinnedHistogram<uint16_t>(256, 0., 65536.).transform(image, hist); });
+    row("float audio 1024 bins", [&] { BinnedHistogram<float>(1024, -1., 1.).transform(audio, hist); });
+    row("double audio 1024 bins", [&] { BinnedHistogram<double>(1024, -1., 1.).transform(audioDouble, hist); });
+}
+
+/**
+ * @brief Thresholding of an 8-bit opencv image: conversions to and from eigen vs the transform itself.
+ */
+static void benchConversion() {
+    cout << "== 2048x2048 8-bit image: opencv2eigen, thresholding, eigen2opencv ==\n";
+    int n = 2048;
+    cv::Mat image(n, n, CV_8U);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            image.at<uchar>(i, j) = (i * 31 + j * 17) % 256;
+        }
+    }
+    Thresholding threshold(30, 200);
+    MatrixXi item, thresholded;
+    cv::Mat output;
+    double in = bestTimeMs([&] { opencv2eigen(image, item); });
+    double transform = bestTimeMs([&] { threshold.transform(item, thresholded); });
+    double out = bestTimeMs([&] { eigen2opencv(thresholded, output); });
+    cout << std::fixed << std::setprecision(2)
+         << std::setw(16) << "opencv2eigen ms" << std::setw(12) << in << "\n"
+         << std::setw(16) << "threshold ms" << std::setw(12) << transform << "\n"
+         << std::setw(16) << "eigen2opencv ms" << std::setw(12) << out << "\n"
+         << std::setw(16) << "conversions" << std::setw(11) << 100 * (in + out) / (in + transform + out) << "%\n";
+}
+
+
+int main(int argc, const char* argv[]) {
+    string which = (argc > 1) ? argv[1] : "all";
+    cout << "FFT kernel: " << fftKernelName() << ", threads: " << ThreadPool::global().size() << "\n";
+
+    if (which == "all" || which == "transpose") {
+        benchTranspose();
+    }
+    if (which == "all" || which == "batch") {
+        benchBatch();
+    }
+    if (which == "all" || which == "backends") {
+        benchBackends((argc > 2) ? argv[2] : "data/images");
+    }
+    if (which == "all" || which == "filterbank") {
+        benchFilterBank();
+    }
+    if (which == "all" || which == "convolution") {
+        benchConvolution();
+    }
+    if (which == "all" || which == "convmethods") {
+        benchConvolutionMethods();
+    }
+    if (which == "all" || which == "frames") {
+        benchFrames();
+    }
+    if (which == "all" || which == "pixels") {
+        benchPixelTypes();
+    }
+    if (which == "all" || which == "threshold") {
+        benchThreshold();
+    }
+    if (which == "all" || which == "lut") {
+        benchLUT();
+    }
+    if (which == "all" || which == "fusion") {
+        benchFusion();
+    }
+    if (which == "all" || which == "binned") {
+        benchBinnedHistogram();
+    }
+    if (which == "all" || which == "conversion") {
+        benchConversion();
+    }
+    if (which == "all" || which == "wisdom") {
+        benchWisdom();
+    }
+    return 0;
+}
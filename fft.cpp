@@ -0,0 +1,731 @@
+#include "fft.hpp"
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <limits>
+#include <functional>
+
+
+// Butterflies of the mixed radix stages
+
+/*complex product without the inf/nan special cases of std::complex (which compile to a library call)*/
+template <typename T>
+static inline std::complex<T> cmul(std::complex<T> a, std::complex<T> b) {
+    return std::complex<T>(a.real() * b.real() - a.imag() * b.imag(),
+                               a.real() * b.imag() + a.imag() * b.real());
+}
+
+/*y_q = sum_p W_R^{pq} a_p for the radices with closed-form butterflies*/
+template <typename T>
+static inline void butterfly2(std::complex<T> a[], int) {
+    std::complex<T> t = a[1];
+    a[1] = a[0] - t;
+    a[0] = a[0] + t;
+}
+
+/*multiply by dir * i*/
+template <typename T>
+static inline std::complex<T> mulDirI(std::complex<T> a, int dir) {
+    return (dir < 0) ? std::complex<T>(a.imag(), -a.real())
+                     : std::complex<T>(-a.imag(), a.real());
+}
+
+template <typename T>
+static inline void butterfly3(std::complex<T> a[], int dir) {
+    const T s = T(0.86602540378443864676);  // sin(2pi/3)
+    std::complex<T> sum = a[1] + a[2];
+    std::complex<T> t = a[0] - T(0.5) * sum;
+    std::complex<T> u = mulDirI(s * (a[1] - a[2]), dir);
+    a[0] = a[0] + sum;
+    a[1] = t + u;
+    a[2] = t - u;
+}
+
+template <typename T>
+static inline void butterfly4(std::complex<T> a[], int dir) {
+    std::complex<T> s02 = a[0] + a[2];
+    std::complex<T> d02 = a[0] - a[2];
+    std::complex<T> s13 = a[1] + a[3];
+    std::complex<T> d13 = mulDirI(a[1] - a[3], dir);
+    a[0] = s02 + s13;
+    a[2] = s02 - s13;
+    a[1] = d02 + d13;
+    a[3] = d02 - d13;
+}
+
+template <typename T>
+static inline void butterfly5(std::complex<T> a[], int dir) {
+    const T c1 = T(0.30901699437494742410);   // cos(2pi/5)
+    const T c2 = T(-0.80901699437494742410);  // cos(4pi/5)
+    const T s1 = T(0.95105651629515357212);   // sin(2pi/5)
+    const T s2 = T(0.58778525229247312917);   // sin(4pi/5)
+    std::complex<T> s14 = a[1] + a[4];
+    std::complex<T> d14 = a[1] - a[4];
+    std::complex<T> s23 = a[2] + a[3];
+    std::complex<T> d23 = a[2] - a[3];
+    std::complex<T> t1 = a[0] + c1 * s14 + c2 * s23;
+    std::complex<T> t2 = a[0] + c2 * s14 + c1 * s23;
+    std::complex<T> u1 = mulDirI(s1 * d14 + s2 * d23, dir);
+    std::complex<T> u2 = mulDirI(s2 * d14 - s1 * d23, dir);
+    a[0] = a[0] + s14 + s23;
+    a[1] = t1 + u1;
+    a[4] = t1 - u1;
+    a[2] = t2 + u2;
+    a[3] = t2 - u2;
+}
+
+template <typename T>
+static inline void butterfly7(std::complex<T> a[], int dir) {
+    /*pairs (q, 7-q) share the cosine part and have opposite sine parts*/
+    static const T c[3] = {T(0.62348980185873353053), T(-0.22252093395631440429), T(-0.90096886790241912624)};
+    static const T s[3] = {T(0.78183148246802980871), T(0.97492791218182360702), T(0.43388373911755812048)};
+    std::complex<T> sum[3], diff[3];
+    for (int q = 0; q < 3; q++) {
+        sum[q] = a[q + 1] + a[6 - q];
+        diff[q] = a[q + 1] - a[6 - q];
+    }
+    std::complex<T> a0 = a[0];
+    a[0] = a0 + sum[0] + sum[1] + sum[2];
+    for (int k = 1; k <= 3; k++) {
+        std::complex<T> t = a0;
+        std::complex<T> u = 0;
+        for (int q = 1; q <= 3; q++) {
+            int idx = (q * k) % 7;  // angle 2pi*q*k/7 reduced to the first 3 harmonics
+            T sign = 1;
+            if (idx > 3) {
+                idx = 7 - idx;
+                sign = -1;
+            }
+            t += c[idx - 1] * sum[q - 1];
+            u += sign * s[idx - 1] * diff[q - 1];
+        }
+        u = mulDirI(u, dir);
+        a[k] = t + u;
+        a[7 - k] = t - u;
+    }
+}
+
+/*merge R sub-transforms of size L into transforms of size R*L*/
+template <typename T, int R, void (*Butterfly)(std::complex<T>[], int)>
+static void radixStage(std::complex<T> x[], int n, int L, const std::complex<T> w[], int dir) {
+    std::complex<T> a[R];
+    for (int k = 0; k < n; k += R * L) {
+        for (int j = 0; j < L; j++) {
+            const std::complex<T> *wj = w + j * (R - 1);
+            a[0] = x[k + j];
+            for (int q = 1; q < R; q++) {
+                a[q] = cmul(wj[q - 1], x[k + j + q * L]);
+            }
+            Butterfly(a, dir);
+            for (int q = 0; q < R; q++) {
+                x[k + j + q * L] = a[q];
+            }
+        }
+    }
+}
+
+
+// FFTPlanChoice
+
+bool FFTPlanChoice::valid(int n) const {
+    if (n < 1) {
+        return false;
+    }
+    switch (strategy) {
+        case Radix2: {
+            if ((n & (n - 1)) != 0 || !radices.empty()) {
+                return false;
+            }
+            std::vector<std::string> names = availableFFTKernels();
+            return kernel.empty() || std::find(names.begin(), names.end(), kernel) != names.end();
+        }
+        case MixedRadix: {
+            long long product = 1;
+            for (int r : radices) {
+                if (r != 2 && r != 3 && r != 4 && r != 5 && r != 7) {
+                    return false;
+                }
+                product *= r;
+            }
+            return product == n && kernel.empty();
+        }
+        case Bluestein:
+            return radices.empty() && kernel.empty();
+    }
+    return false;
+}
+
+bool FFTPlanChoice::operator==(const FFTPlanChoice &other) const {
+    return strategy == other.strategy && radices == other.radices && kernel == other.kernel;
+}
+
+
+// FFTPlan
+
+/*precision of the plans in the wisdom*/
+template <typename T>
+static const char *precisionName() {
+    return (sizeof(T) == sizeof(float)) ? "float" : "double";
+}
+
+template <typename T>
+FFTPlan<T>::FFTPlan(int n_, int dir_) : FFTPlan(n_, dir_, estimate(n_)) {
+}
+
+template <typename T>
+FFTPlan<T>::FFTPlan(int n_, int dir_, const FFTPlanChoice &choice) {
+    n = n_;
+    dir = dir_;
+    strat = choice.strategy;
+
+    if (n < 1) {
+        throw std::invalid_argument("FFT size must be positive, got " + std::to_string(n));
+    }
+    if (dir != -1 && dir != 1) {
+        throw std::invalid_argument("FFT direction must be -1 or 1");
+    }
+    if (!choice.valid(n)) {
+        throw std::invalid_argument("Invalid FFT plan choice for size " + std::to_string(n));
+    }
+
+    if (strat == Bluestein) {
+        /*X_k = c_k sum_j (x_j c_j) conj(c_{k-j}), a circular convolution of power-of-two size*/
+        int m = 1;
+        while (m < 2 * n - 1) {
+            m *= 2;
+        }
+        chirp.resize(n);
+        for (long long k = 0; k < n; k++) {
+            /*k^2 mod 2n keeps the angle accurate for large k*/
+            chirp[k] = std::polar(1.0, dir * M_PI * double((k * k) % (2LL * n)) / n);
+        }
+        chirpSpectrum.assign(m, 0);
+        chirpSpectrum[0] = std::conj(chirp[0]);
+        for (int k = 1; k < n; k++) {
+            chirpSpectrum[k] = std::conj(chirp[k]);
+            chirpSpectrum[m - k] = std::conj(chirp[k]);
+        }
+        convForward = FFTPlan<T>::get(m, -1);
+        convInverse = FFTPlan<T>::get(m, 1);
+        convForward->execute(chirpSpectrum.data());
+        for (auto &c : chirpSpectrum) {
+            c /= T(m);
+        }
+        return;
+    }
+
+    if (strat == Radix2) {
+        /*power of two: radix-4 stages with an optional leading radix-2 stage*/
+        int log2n = 0;
+        while ((1 << log2n) < n) {
+            log2n++;
+        }
+        if (log2n % 2 == 1) {
+            radices.push_back(2);
+        }
+        radices.insert(radices.end(), log2n / 2, 4);
+        if (!choice.kernel.empty()) {
+            kernel = &findFFTKernel(choice.kernel);
+        }
+
+        /*bit-reversal permutation*/
+        perm.resize(n);
+        for (int i = 0; i < n; i++) {
+            int rev = 0;
+            for (int b = 0; b < log2n; b++) {
+                rev |= ((i >> b) & 1) << (log2n - 1 - b);
+            }
+            perm[i] = rev;
+        }
+
+        /*twiddles of the radix-4 stages: W_{4L}^j followed by W_{2L}^j for j < L*/
+        for (int L = (log2n % 2 == 1) ? 2 : 1; 4 * L <= n; L *= 4) {
+            for (int j = 0; j < L; j++) {
+                twiddlesRe.push_back(std::cos(dir * 2 * M_PI * j / (4.0 * L)));
+                twiddlesIm.push_back(std::sin(dir * 2 * M_PI * j / (4.0 * L)));
+            }
+            for (int j = 0; j < L; j++) {
+                twiddlesRe.push_back(std::cos(dir * 2 * M_PI * j / (2.0 * L)));
+                twiddlesIm.push_back(std::sin(dir * 2 * M_PI * j / (2.0 * L)));
+            }
+        }
+        return;
+    }
+
+    /*mixed radix: digit-reversal permutation, twiddles W_{RL}^{qj} for j < L, 0 < q < R*/
+    radices = choice.radices;
+    perm.resize(n);
+    for (int i = 0; i < n; i++) {
+        int pos = 0;
+        int block = n;
+        int idx = i;
+        for (int s = int(radices.size()) - 1; s >= 0; s--) {
+            block /= radices[s];
+            pos += (idx % radices[s]) * block;
+            idx /= radices[s];
+        }
+        perm[i] = pos;
+    }
+
+    int L = 1;
+    for (int r : radices) {
+        for (int j = 0; j < L; j++) {
+            for (int q = 1; q < r; q++) {
+                twiddles.emplace_back(std::polar(1.0, dir * 2 * M_PI * q * j / double(r * L)));
+            }
+        }
+        L *= r;
+    }
+}
+
+template <typename T>
+FFTPlanChoice FFTPlan<T>::estimate(int n) {
+    if (n < 1) {
+        throw std::invalid_argument("FFT size must be positive, got " + std::to_string(n));
+    }
+
+    /*factorize the size into the supported radices*/
+    FFTPlanChoice choice;
+    int rest = n;
+    while (rest % 4 == 0) {
+        choice.radices.push_back(4);
+        rest /= 4;
+    }
+    for (int r : {2, 3, 5, 7}) {
+        while (rest % r == 0) {
+            choice.radices.push_back(r);
+            rest /= r;
+        }
+    }
+
+    if (rest > 1) {
+        /*large prime factor*/
+        choice.strategy = FFTPlanChoice::Bluestein;
+        choice.radices.clear();
+    } else if ((n & (n - 1)) == 0) {
+        /*the radices of the power-of-two plans are fixed by the size*/
+        choice.strategy = FFTPlanChoice::Radix2;
+        choice.radices.clear();
+    } else {
+        choice.strategy = FFTPlanChoice::MixedRadix;
+    }
+    return choice;
+}
+
+template <typename T>
+FFTPlanChoice FFTPlan<T>::measure(int n, int dir) {
+    FFTPlanChoice estimated = estimate(n);
+    std::vector<FFTPlanChoice> candidates = {estimated};
+
+    if (estimated.strategy == FFTPlanChoice::Radix2) {
+        /*every kernel supported by the CPU, and the complex-array mixed radix path*/
+        for (const auto &name : availableFFTKernels()) {
+            FFTPlanChoice choice = estimated;
+            choice.kernel = name;
+            candidates.push_back(choice);
+        }
+        if (n >= 4) {
+            FFTPlanChoice choice;
+            choice.strategy = FFTPlanChoice::MixedRadix;
+            for (int rest = n; rest > 1; rest /= (rest % 4 == 0) ? 4 : 2) {
+                choice.radices.push_back((rest % 4 == 0) ? 4 : 2);
+            }
+            candidates.push_back(choice);
+        }
+    } else if (estimated.strategy == FFTPlanChoice::MixedRadix) {
+        /*largest radices first, radix 2 instead of 4, and Bluestein*/
+        FFTPlanChoice reversed = estimated;
+        std::sort(reversed.radices.begin(), reversed.radices.end(), std::greater<int>());
+        candidates.push_back(reversed);
+        FFTPlanChoice split;
+        split.strategy = FFTPlanChoice::MixedRadix;
+        for (int r : estimated.radices) {
+            if (r == 4) {
+                split.radices.push_back(2);
+                split.radices.push_back(2);
+            } else {
+                split.radices.push_back(r);
+            }
+        }
+        candidates.push_back(split);
+        FFTPlanChoice bluestein;
+        bluestein.strategy = FFTPlanChoice::Bluestein;
+        candidates.push_back(bluestein);
+    }
+    if (candidates.size() == 1) {
+        return estimated;
+    }
+
+    /*best time per transform of a few rounds of at least ~64K points, on a fresh copy of the input*/
+    std::vector<std::complex<T>> input(n), data(n);
+    for (int i = 0; i < n; i++) {
+        input[i] = std::complex<T>(T(i % 13), T(i % 7));
+    }
+    int reps = std::max(1, (1 << 16) / n);
+    FFTPlanChoice best = estimated;
+    double bestTime = std::numeric_limits<double>::infinity();
+    for (const auto &choice : candidates) {
+        FFTPlan<T> plan(n, dir, choice);
+        double time = std::numeric_limits<double>::infinity();
+        for (int round = 0; round < 3; round++) {
+            auto begin = std::chrono::steady_clock::now();
+            for (int r = 0; r < reps; r++) {
+                std::copy(input.begin(), input.end(), data.begin());
+                plan.execute(data.data());
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+            time = std::min(time, elapsed.count());
+        }
+        if (time < bestTime) {
+            bestTime = time;
+            best = choice;
+        }
+    }
+    return best;
+}
+
+/*plan caches: the first thread that asks for a key builds the plan (and measures it when autotuning)
+  while the other threads wait for it, so that the workers of a parallel loop do not all time the same
+  size against each other. The plan is built outside of the lock: Bluestein plans request their own sub-plans.*/
+template <typename Key, typename Plan, typename Build>
+static std::shared_ptr<const Plan> cachedPlan(std::map<Key, std::shared_future<std::shared_ptr<const Plan>>> &cache,
+                                              std::mutex &cache_mutex, const Key &key, Build build) {
+    std::promise<std::shared_ptr<const Plan>> promise;
+    std::shared_future<std::shared_ptr<const Plan>> pending;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto found = cache.find(key);
+        if (found != cache.end()) {
+            pending = found->second;
+        } else {
+            cache.emplace(key, promise.get_future().share());
+        }
+    }
+    if (pending.valid()) {
+        return pending.get();
+    }
+    try {
+        auto plan = build();
+        promise.set_value(plan);
+        return plan;
+    } catch (...) {
+        /*the waiting threads get the error, the next request tries again*/
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.erase(key);
+        throw;
+    }
+}
+
+template <typename T>
+std::shared_ptr<const FFTPlan<T>> FFTPlan<T>::get(int n, int dir) {
+    static std::map<std::pair<int, int>, std::shared_future<std::shared_ptr<const FFTPlan<T>>>> cache;
+    static std::mutex cache_mutex;
+
+    return cachedPlan(cache, cache_mutex, std::make_pair(n, dir), [n, dir] {
+        FFTPlanChoice choice;
+        if (!FFTWisdom::lookup(n, dir, precisionName<T>(), choice)) {
+            if (FFTWisdom::autotune()) {
+                choice = measure(n, dir);
+                FFTWisdom::record(n, dir, precisionName<T>(), choice);
+            } else {
+                choice = estimate(n);
+            }
+        }
+        return std::make_shared<const FFTPlan<T>>(n, dir, choice);
+    });
+}
+
+template <typename T>
+int FFTPlan<T>::size() const {
+    return n;
+}
+
+template <typename T>
+int FFTPlan<T>::direction() const {
+    return dir;
+}
+
+template <typename T>
+typename FFTPlan<T>::Strategy FFTPlan<T>::strategy() const {
+    return strat;
+}
+
+template <typename T>
+const std::vector<int>& FFTPlan<T>::getRadices() const {
+    return radices;
+}
+
+template <typename T>
+FFTPlanChoice FFTPlan<T>::choice() const {
+    FFTPlanChoice result;
+    result.strategy = strat;
+    if (strat == MixedRadix) {
+        result.radices = radices;
+    }
+    if (kernel != nullptr) {
+        result.kernel = kernel->name;
+    }
+    return result;
+}
+
+template <typename T>
+void FFTPlan<T>::execute(std::complex<T> data[]) const {
+    switch (strat) {
+        case Radix2:
+            executeRadix2(data);
+            break;
+        case MixedRadix:
+            executeMixedRadix(data);
+            break;
+        case Bluestein:
+            executeBluestein(data);
+            break;
+    }
+}
+
+template <typename T>
+void FFTPlan<T>::executeRadix2(std::complex<T> data[]) const {
+    thread_local std::vector<T> re, im;
+    if (int(re.size()) < n) {
+        re.resize(n);
+        im.resize(n);
+    }
+
+    /*split into real and imaginary arrays, applying the bit-reversal permutation*/
+    for (int i = 0; i < n; i++) {
+        re[perm[i]] = data[i].real();
+        im[perm[i]] = data[i].imag();
+    }
+
+    /*odd number of radix-2 stages: do the first one separately (all twiddles are 1)*/
+    int L = 1;
+    if (!radices.empty() && radices[0] == 2) {
+        for (int k = 0; k < n; k += 2) {
+            T ar = re[k], ai = im[k];
+            re[k] = ar + re[k + 1];
+            im[k] = ai + im[k + 1];
+            re[k + 1] = ar - re[k + 1];
+            im[k + 1] = ai - im[k + 1];
+        }
+        L = 2;
+    }
+
+    /*radix-4 stages: merge four sub-transforms of size L into one of size 4L*/
+    const FFTKernel &vector = (kernel != nullptr) ? *kernel : fftKernel();
+    const FFTKernel &scalar = fftScalarKernel();
+    int offset = 0;
+    for (; 4 * L <= n; L *= 4) {
+        const FFTRadix4Stage<T> stage = (L % vector.lanes<T>() == 0) ? vector.radix4<T>() : scalar.radix4<T>();
+        stage(re.data(), im.data(), n, L,
+              twiddlesRe.data() + offset, twiddlesIm.data() + offset,
+              twiddlesRe.data() + offset + L, twiddlesIm.data() + offset + L, dir);
+        offset += 2 * L;
+    }
+
+    for (int i = 0; i < n; i++) {
+        data[i] = std::complex<T>(re[i], im[i]);
+    }
+}
+
+template <typename T>
+void FFTPlan<T>::executeMixedRadix(std::complex<T> data[]) const {
+    thread_local std::vector<std::complex<T>> scratch;
+    if (int(scratch.size()) < n) {
+        scratch.resize(n);
+    }
+    std::complex<T> *x = scratch.data();
+    for (int i = 0; i < n; i++) {
+        x[perm[i]] = data[i];
+    }
+
+    const std::complex<T> *w = twiddles.data();
+    int L = 1;
+    for (int r : radices) {
+        switch (r) {
+            case 2: radixStage<T, 2, butterfly2<T>>(x, n, L, w, dir); break;
+            case 3: radixStage<T, 3, butterfly3<T>>(x, n, L, w, dir); break;
+            case 4: radixStage<T, 4, butterfly4<T>>(x, n, L, w, dir); break;
+            case 5: radixStage<T, 5, butterfly5<T>>(x, n, L, w, dir); break;
+            case 7: radixStage<T, 7, butterfly7<T>>(x, n, L, w, dir); break;
+        }
+        w += L * (r - 1);
+        L *= r;
+    }
+    std::copy(x, x + n, data);
+}
+
+template <typename T>
+void FFTPlan<T>::executeBluestein(std::complex<T> data[]) const {
+    int m = convForward->size();
+    thread_local std::vector<std::complex<T>> scratch;
+    if (int(scratch.size()) < m) {
+        scratch.resize(m);
+    }
+    std::complex<T> *a = scratch.data();
+    for (int k = 0; k < n; k++) {
+        a[k] = cmul(data[k], chirp[k]);
+    }
+    std::fill(a + n, a + m, std::complex<T>(0));
+
+    convForward->execute(a);
+    for (int k = 0; k < m; k++) {
+        a[k] = cmul(a[k], chirpSpectrum[k]);
+    }
+    convInverse->execute(a);
+
+    for (int k = 0; k < n; k++) {
+        data[k] = cmul(a[k], chirp[k]);
+    }
+}
+
+template <typename T>
+void FFTPlan<T>::execute(std::complex<T> data[], int stride, std::complex<T> buffer[]) const {
+    if (stride == 1) {
+        execute(data);
+        return;
+    }
+    for (int k = 0; k < n; k++) {
+        buffer[k] = data[k * stride];
+    }
+    execute(buffer);
+    for (int k = 0; k < n; k++) {
+        data[k * stride] = buffer[k];
+    }
+}
+
+
+// Transpose
+
+template <typename T>
+void transposeBlocked(const std::complex<T> in[], std::complex<T> out[], int rows, int cols,
+                      int outRowBegin, int outRowEnd) {
+    /*32x32 tiles: 8KB (float) or 16KB (double) read and written per tile*/
+    const int tile = 32;
+    for (int r0 = outRowBegin; r0 < outRowEnd; r0 += tile) {
+        int r1 = std::min(r0 + tile, outRowEnd);
+        for (int c0 = 0; c0 < rows; c0 += tile) {
+            int c1 = std::min(c0 + tile, rows);
+            for (int r = r0; r < r1; r++) {
+                for (int c = c0; c < c1; c++) {
+                    out[r * rows + c] = in[c * cols + r];
+                }
+            }
+        }
+    }
+}
+
+
+// RealFFTPlan
+
+template <typename T>
+RealFFTPlan<T>::RealFFTPlan(int n_) {
+    n = n_;
+    if (n < 1) {
+        throw std::invalid_argument("FFT size must be positive, got " + std::to_string(n));
+    }
+    int m = (n % 2 == 0) ? n / 2 : n;
+    forwardPlan = FFTPlan<T>::get(m, -1);
+    inversePlan = FFTPlan<T>::get(m, 1);
+    if (n % 2 == 0) {
+        for (int k = 0; k < n / 2; k++) {
+            twiddles.emplace_back(std::polar(1.0, -2 * M_PI * k / n));
+        }
+    }
+}
+
+template <typename T>
+std::shared_ptr<const RealFFTPlan<T>> RealFFTPlan<T>::get(int n) {
+    static std::map<int, std::shared_future<std::shared_ptr<const RealFFTPlan<T>>>> cache;
+    static std::mutex cache_mutex;
+
+    return cachedPlan(cache, cache_mutex, n, [n] {
+        return std::make_shared<const RealFFTPlan<T>>(n);
+    });
+}
+
+template <typename T>
+int RealFFTPlan<T>::size() const {
+    return n;
+}
+
+template <typename T>
+void RealFFTPlan<T>::r2c(const T in[], std::complex<T> out[]) const {
+    if (n % 2 == 1) {
+        thread_local std::vector<std::complex<T>> scratch;
+        scratch.assign(in, in + n);
+        forwardPlan->execute(scratch.data());
+        std::copy(scratch.begin(), scratch.begin() + n / 2 + 1, out);
+        return;
+    }
+
+    /*pack even and odd samples into z_m = x_{2m} + i x_{2m+1} and transform with size m = n/2*/
+    int m = n / 2;
+    for (int k = 0; k < m; k++) {
+        out[k] = std::complex<T>(in[2 * k], in[2 * k + 1]);
+    }
+    forwardPlan->execute(out);
+
+    /*split Z into the spectra E (even samples) and O (odd samples): X_k = E_k + W_n^k O_k*/
+    std::complex<T> z0 = out[0];
+    out[0] = std::complex<T>(z0.real() + z0.imag(), 0);
+    out[m] = std::complex<T>(z0.real() - z0.imag(), 0);
+    for (int k = 1; k <= m / 2; k++) {
+        int j = m - k;
+        std::complex<T> zk = out[k];
+        std::complex<T> zj = out[j];
+        std::complex<T> ek = T(0.5) * (zk + std::conj(zj));
+        std::complex<T> ok = mulDirI(T(0.5) * (zk - std::conj(zj)), -1);
+        std::complex<T> ej = T(0.5) * (zj + std::conj(zk));
+        std::complex<T> oj = mulDirI(T(0.5) * (zj - std::conj(zk)), -1);
+        out[k] = ek + cmul(twiddles[k], ok);
+        out[j] = ej + cmul(twiddles[j], oj);
+    }
+}
+
+template <typename T>
+void RealFFTPlan<T>::c2r(const std::complex<T> in[], T out[]) const {
+    thread_local std::vector<std::complex<T>> scratch;
+
+    if (n % 2 == 1) {
+        /*rebuild the full Hermitian spectrum*/
+        scratch.resize(n);
+        scratch[0] = std::complex<T>(in[0].real(), 0);
+        for (int k = 1; k <= n / 2; k++) {
+            scratch[k] = in[k];
+            scratch[n - k] = std::conj(in[k]);
+        }
+        inversePlan->execute(scratch.data());
+        for (int k = 0; k < n; k++) {
+            out[k] = scratch[k].real();
+        }
+        return;
+    }
+
+    /*z_k = (X_k + X_{k+m}) + i W_n^{-k} (X_k - X_{k+m}) transforms back into x_{2j} + i x_{2j+1}*/
+    int m = n / 2;
+    scratch.resize(m);
+    for (int k = 0; k < m; k++) {
+        std::complex<T> a = (k == 0) ? std::complex<T>(in[0].real(), 0) : in[k];
+        std::complex<T> b = (k == 0) ? std::complex<T>(in[m].real(), 0) : std::conj(in[m - k]);
+        scratch[k] = (a + b) + mulDirI(cmul(std::conj(twiddles[k]), a - b), 1);
+    }
+    inversePlan->execute(scratch.data());
+    for (int k = 0; k < m; k++) {
+        out[2 * k] = scratch[k].real();
+        out[2 * k + 1] = scratch[k].imag();
+    }
+}
+
+
+template class FFTPlan<float>;
+template class FFTPlan<double>;
+template class RealFFTPlan<float>;
+template class RealFFTPlan<double>;
+template void transposeBlocked(const std::complex<float> in[], std::complex<float> out[], int rows, int cols,
+                               int outRowBegin, int outRowEnd);
+template void transposeBlocked(const std::complex<double> in[], std::complex<double> out[], int rows, int cols,
+                               int outRowBegin, int outRowEnd);
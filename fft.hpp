@@ -0,0 +1,486 @@
+#ifndef FFT_ENGINE
+#define FFT_ENGINE
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+
+/**
+ * @brief Radix-4 stage of a power-of-two FFT on split (SoA) real/imaginary arrays.
+ * Instantiated for float and double precision.
+ * Merges the sub-transforms of size L of every block of 4L values into transforms of size 4L.
+ *
+ * @param re[] real parts of the n values
+ * @param im[] imaginary parts of the n values
+ * @param n number of values
+ * @param L size of the sub-transforms
+ * @param w1re[], w1im[] twiddles W_{4L}^j for j < L
+ * @param w2re[], w2im[] twiddles W_{2L}^j for j < L
+ * @param dir -1 for FFT, 1 for inverse FFT
+ */
+template <typename T>
+using FFTRadix4Stage = void (*)(T re[], T im[], int n, int L, const T w1re[], const T w1im[],
+                                const T w2re[], const T w2im[], int dir);
+
+/**
+ * @brief Vectorized butterfly kernel (one per instruction set).
+ */
+struct FFTKernel {
+    const char *name; /// name of the instruction set (scalar, sse2, avx2, avx512)
+    int width; /// number of floats per vector, stages with L % width != 0 run on the scalar kernel
+    bool (*supported)(); /// check if the CPU supports the kernel
+    FFTRadix4Stage<float> radix4f; /// radix-4 stage in single precision
+    FFTRadix4Stage<double> radix4d; /// radix-4 stage in double precision (width / 2 doubles per vector)
+
+    /**
+     * @brief Radix-4 stage for the precision T.
+     */
+    template <typename T>
+    FFTRadix4Stage<T> radix4() const;
+
+    /**
+     * @brief Number of values of type T per vector.
+     */
+    template <typename T>
+    int lanes() const {
+        return std::max(1, width * int(sizeof(float)) / int(sizeof(T)));
+    }
+};
+
+template <>
+inline FFTRadix4Stage<float> FFTKernel::radix4<float>() const {
+    return radix4f;
+}
+
+template <>
+inline FFTRadix4Stage<double> FFTKernel::radix4<double>() const {
+    return radix4d;
+}
+
+/**
+ * @brief Butterfly kernel used by the plans.
+ * By default the widest kernel supported by the CPU (detected at runtime with CPUID).
+ */
+const FFTKernel& fftKernel();
+
+/**
+ * @brief Portable butterfly kernel, used for the stages that are too small for the vector width.
+ */
+const FFTKernel& fftScalarKernel();
+
+/**
+ * @brief Name of the butterfly kernel used by the plans (e.g., for logs).
+ */
+std::string fftKernelName();
+
+/**
+ * @brief Names of the butterfly kernels supported by the CPU, from the widest to the narrowest.
+ */
+std::vector<std::string> availableFFTKernels();
+
+/**
+ * @brief Butterfly kernel with the given name.
+ * Throws std::invalid_argument if the kernel does not exist or is not supported by the CPU.
+ *
+ * @param name Name of the kernel
+ */
+const FFTKernel& findFFTKernel(const std::string& name);
+
+/**
+ * @brief Force the butterfly kernel used by the plans (e.g., for testing and benchmarking).
+ * Throws std::invalid_argument if the kernel does not exist or is not supported by the CPU.
+ *
+ * @param name Name of the kernel
+ */
+void setFFTKernel(const std::string& name);
+
+
+/**
+ * @brief Name of the CPU features that select the butterfly kernels (e.g., "sse2+avx2+fma+avx512f").
+ * Used to key the wisdom, since tuned choices are only valid on CPUs with the same features.
+ */
+std::string fftCPUFeatures();
+
+
+/**
+ * @brief Parameters of a plan that can be tuned by measurement and saved in the wisdom.
+ */
+struct FFTPlanChoice {
+    /**
+     * @brief Algorithm used by a plan.
+     */
+    enum Strategy { Radix2, MixedRadix, Bluestein };
+
+    Strategy strategy = Radix2; /// algorithm of the plan
+    std::vector<int> radices; /// radix of every stage, in the order the stages are applied (MixedRadix only)
+    std::string kernel; /// butterfly kernel (Radix2 only), empty to use the kernel selected with setFFTKernel
+
+    /**
+     * @brief Check if the choice can be used for a transform of size n on this CPU.
+     *
+     * @param n Size of the transform
+     */
+    bool valid(int n) const;
+
+    bool operator==(const FFTPlanChoice& other) const;
+};
+
+
+/**
+ * @brief Precomputed plan of a 1D Fast Fourier transform of a fixed size and direction.
+ * The plan picks a strategy from the factorization of the size:
+ * - power of two: bit-reversal permutation and iterative radix-4 stages (plus one radix-2 stage
+ *   when log2(n) is odd) on split real/imaginary arrays, using the vectorized fftKernel();
+ * - product of 2, 3, 5 and 7: digit-reversal permutation and mixed radix stages (2, 3, 4, 5, 7);
+ * - anything else (large prime factors): Bluestein's chirp-z algorithm, i.e. a circular
+ *   convolution computed with power-of-two plans.
+ * All twiddle factors are precomputed. Plans are immutable and can be shared between threads.
+ *
+ * @tparam T Precision of the computation (float or double).
+ */
+template <typename T>
+class FFTPlan {
+public:
+    using Strategy = FFTPlanChoice::Strategy;
+    static constexpr Strategy Radix2 = FFTPlanChoice::Radix2;
+    static constexpr Strategy MixedRadix = FFTPlanChoice::MixedRadix;
+    static constexpr Strategy Bluestein = FFTPlanChoice::Bluestein;
+
+private:
+    int n; /// size of the transform
+    int dir; /// for FFT, dir = -1, for inverse FFT, dir = 1
+    Strategy strat; /// algorithm chosen for this size
+    const FFTKernel *kernel = nullptr; /// butterfly kernel fixed by the choice (Radix2), nullptr for fftKernel()
+    std::vector<int> radices; /// radix of every stage, in the order the stages are applied
+    std::vector<int> perm; /// position of every input element after the bit/digit-reversal permutation
+    std::vector<std::complex<T>> twiddles; /// twiddle factors of all stages, stored stage after stage (MixedRadix)
+    std::vector<T> twiddlesRe; /// split twiddle factors of all stages, stored stage after stage (Radix2)
+    std::vector<T> twiddlesIm;
+    std::vector<std::complex<T>> chirp; /// chirp exp(dir*i*pi*k^2/n) (Bluestein)
+    std::vector<std::complex<T>> chirpSpectrum; /// spectrum of the conjugate chirp divided by its size (Bluestein)
+    std::shared_ptr<const FFTPlan<T>> convForward; /// power-of-two plans of the Bluestein convolution
+    std::shared_ptr<const FFTPlan<T>> convInverse;
+
+    void executeRadix2(std::complex<T> data[]) const;
+    void executeMixedRadix(std::complex<T> data[]) const;
+    void executeBluestein(std::complex<T> data[]) const;
+
+public:
+    /**
+     * @brief Construct a new FFT plan of arbitrary size.
+     *
+     * @param n_ Size of the transform (positive)
+     * @param dir_ Direction of the transform: -1 for FFT, 1 for inverse FFT
+     */
+    FFTPlan(int n_, int dir_);
+
+    /**
+     * @brief Construct a new FFT plan with the given (e.g., tuned) parameters.
+     * Throws std::invalid_argument if the choice is not valid for the size.
+     *
+     * @param n_ Size of the transform (positive)
+     * @param dir_ Direction of the transform: -1 for FFT, 1 for inverse FFT
+     * @param choice Strategy, radices and kernel of the plan
+     */
+    FFTPlan(int n_, int dir_, const FFTPlanChoice& choice);
+
+    /**
+     * @brief Default parameters for a size, picked from its factorization without measurement.
+     *
+     * @param n Size of the transform (positive)
+     */
+    static FFTPlanChoice estimate(int n);
+
+    /**
+     * @brief Fastest parameters for a size, found by timing the candidate plans
+     * (butterfly kernels, radix orders, mixed radix vs Bluestein).
+     *
+     * @param n Size of the transform (positive)
+     * @param dir Direction of the transform: -1 for FFT, 1 for inverse FFT
+     */
+    static FFTPlanChoice measure(int n, int dir);
+
+    /**
+     * @brief Get a shared plan for the given size and direction.
+     * Plans are built on first request and cached, so repeated transforms of the same size
+     * pay the setup cost only once; concurrent requests for a plan being built wait for it. The parameters come from the wisdom if it has an entry for the plan,
+     * otherwise they are measured (and recorded in the wisdom) when autotuning is enabled, or estimated.
+     *
+     * @param n Size of the transform
+     * @param dir Direction of the transform: -1 for FFT, 1 for inverse FFT
+     * @return std::shared_ptr<const FFTPlan<T>> Cached plan
+     */
+    static std::shared_ptr<const FFTPlan<T>> get(int n, int dir);
+
+    /**
+     * @brief Size of the transform.
+     */
+    int size() const;
+
+    /**
+     * @brief Direction of the transform (-1 for FFT, 1 for inverse FFT).
+     */
+    int direction() const;
+
+    /**
+     * @brief Algorithm chosen for the size of the plan.
+     */
+    Strategy strategy() const;
+
+    /**
+     * @brief Radices of the stages (empty for Bluestein plans).
+     */
+    const std::vector<int>& getRadices() const;
+
+    /**
+     * @brief Parameters of the plan (e.g., to record them in the wisdom).
+     */
+    FFTPlanChoice choice() const;
+
+    /**
+     * @brief Transform a contiguous signal in place (unnormalized).
+     *
+     * @param data[] array of size() complex values
+     */
+    void execute(std::complex<T> data[]) const;
+
+    /**
+     * @brief Transform a strided signal in place (unnormalized).
+     * The signal is gathered into the buffer, transformed and scattered back.
+     *
+     * @param data[] first element of the signal
+     * @param stride distance between consecutive elements of the signal
+     * @param buffer[] scratch array of at least size() elements
+     */
+    void execute(std::complex<T> data[], int stride, std::complex<T> buffer[]) const;
+};
+
+
+/**
+ * @brief Plan parameters ("wisdom") keyed by size, direction, precision and CPU features.
+ * FFTPlan::get builds its plans from the wisdom, so the wisdom saved by a tuned run can be loaded
+ * at startup to get the tuned plans without measuring them again. The file is a text file with one
+ * plan per line; entries of other CPUs are kept in the file but never used.
+ * Load the wisdom before the first transform: plans already in the cache are not rebuilt.
+ */
+class FFTWisdom {
+public:
+    /**
+     * @brief Find the parameters of a plan for the current CPU.
+     *
+     * @param n Size of the transform
+     * @param dir Direction of the transform
+     * @param precision Precision of the transform ("float" or "double")
+     * @param choice Found parameters
+     * @return true if the wisdom has an entry for the plan
+     */
+    static bool lookup(int n, int dir, const std::string& precision, FFTPlanChoice& choice);
+
+    /**
+     * @brief Add (or replace) the parameters of a plan for the current CPU.
+     */
+    static void record(int n, int dir, const std::string& precision, const FFTPlanChoice& choice);
+
+    /**
+     * @brief Merge the entries of a wisdom file into the wisdom.
+     * Throws std::invalid_argument if the file is malformed.
+     *
+     * @param path Path of the wisdom file
+     * @return false if the file cannot be opened (e.g., first run)
+     */
+    static bool load(const std::string& path);
+
+    /**
+     * @brief Write all the entries of the wisdom to a file.
+     * Throws std::invalid_argument if the file cannot be written.
+     *
+     * @param path Path of the wisdom file
+     */
+    static void save(const std::string& path);
+
+    /**
+     * @brief Remove all the entries.
+     */
+    static void clear();
+
+    /**
+     * @brief Check if entries were recorded since the last load, save or clear.
+     */
+    static bool modified();
+
+    /**
+     * @brief Enable the measurement of the plans missing from the wisdom (disabled by default).
+     */
+    static void setAutotune(bool enabled);
+
+    /**
+     * @brief Check if the plans missing from the wisdom are measured.
+     */
+    static bool autotune();
+};
+
+
+/**
+ * @brief Implementation of the 1D Fourier transforms used by the transforms (FFT1D, FFT2D, ...).
+ * Adapters exist for the in-house plans ("inhouse"), Eigen's kissfft ("eigen") and cv::dft ("opencv"),
+ * so that the fastest one can be picked for a deployment and the in-house engine checked against them.
+ * All transforms are unnormalized and thread-safe.
+ */
+class FFTBackend {
+public:
+    virtual ~FFTBackend() = default;
+
+    /**
+     * @brief Name of the backend (used to select it).
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Transform a contiguous signal in place.
+     *
+     * @param data[] array of n complex values
+     * @param n size of the transform
+     * @param dir -1 for FFT, 1 for inverse FFT
+     */
+    virtual void execute(std::complex<float> data[], int n, int dir) const = 0;
+    virtual void execute(std::complex<double> data[], int n, int dir) const = 0;
+
+    /**
+     * @brief Forward transform of a real signal (first n/2+1 coefficients of its spectrum).
+     * By default computed with a complex transform of size n.
+     */
+    virtual void r2c(const float in[], std::complex<float> out[], int n) const;
+    virtual void r2c(const double in[], std::complex<double> out[], int n) const;
+
+    /**
+     * @brief Inverse transform of a Hermitian spectrum given by its first n/2+1 coefficients
+     * (same conventions as RealFFTPlan::c2r). By default computed with a complex transform of size n.
+     */
+    virtual void c2r(const std::complex<float> in[], float out[], int n) const;
+    virtual void c2r(const std::complex<double> in[], double out[], int n) const;
+
+    /**
+     * @brief Transform a strided signal in place, gathering it into the buffer.
+     *
+     * @param data[] first element of the signal
+     * @param n size of the transform
+     * @param dir -1 for FFT, 1 for inverse FFT
+     * @param stride distance between consecutive elements of the signal
+     * @param buffer[] scratch array of at least n elements
+     */
+    template <typename T>
+    void execute(std::complex<T> data[], int n, int dir, int stride, std::complex<T> buffer[]) const {
+        if (stride == 1) {
+            execute(data, n, dir);
+            return;
+        }
+        for (int k = 0; k < n; k++) {
+            buffer[k] = data[k * stride];
+        }
+        execute(buffer, n, dir);
+        for (int k = 0; k < n; k++) {
+            data[k * stride] = buffer[k];
+        }
+    }
+};
+
+/**
+ * @brief Backend used by the transforms (the in-house plans by default).
+ */
+const FFTBackend& fftBackend();
+
+/**
+ * @brief Names of the available backends, the in-house one first.
+ */
+std::vector<std::string> availableFFTBackends();
+
+/**
+ * @brief Select the backend used by the transforms.
+ * Throws std::invalid_argument if the backend does not exist.
+ *
+ * @param name Name of the backend
+ */
+void setFFTBackend(const std::string& name);
+
+
+/**
+ * @brief Cache-blocked out-of-place transpose of a row-major complex matrix.
+ * Only the output rows [outRowBegin, outRowEnd) (i.e. the input columns) are written, so that
+ * stripes of the output can be transposed by different threads. The matrix is processed in
+ * square tiles that fit in the L1 cache, so that both reads and writes stay cache and TLB friendly.
+ *
+ * @param in[] input matrix (rows x cols, row-major)
+ * @param out[] output matrix (cols x rows, row-major)
+ * @param rows number of rows of the input
+ * @param cols number of columns of the input
+ * @param outRowBegin first output row to write
+ * @param outRowEnd past-the-end output row to write
+ */
+template <typename T>
+void transposeBlocked(const std::complex<T> in[], std::complex<T> out[], int rows, int cols,
+                      int outRowBegin, int outRowEnd);
+
+
+/**
+ * @brief Precomputed plan of a 1D Fourier transform of a real signal of a fixed size.
+ * The forward transform (r2c) only computes the n/2+1 non-redundant coefficients of the
+ * Hermitian spectrum, and the inverse (c2r) reconstructs the real signal from them.
+ * For even sizes the real signal is packed into a complex signal of size n/2, which halves
+ * the work of the complex FFT; odd sizes fall back to a complex FFT of size n.
+ *
+ * @tparam T Precision of the computation (float or double).
+ */
+template <typename T>
+class RealFFTPlan {
+private:
+    int n; /// size of the real signal
+    std::shared_ptr<const FFTPlan<T>> forwardPlan; /// complex plans of size n/2 (even n) or n (odd n)
+    std::shared_ptr<const FFTPlan<T>> inversePlan;
+    std::vector<std::complex<T>> twiddles; /// exp(-2*pi*i*k/n) for k < n/2 (even n)
+
+public:
+    /**
+     * @brief Construct a new real FFT plan.
+     *
+     * @param n_ Size of the real signal (positive)
+     */
+    explicit RealFFTPlan(int n_);
+
+    /**
+     * @brief Get a shared plan for the given size (built on first request and cached).
+     *
+     * @param n Size of the real signal
+     * @return std::shared_ptr<const RealFFTPlan<T>> Cached plan
+     */
+    static std::shared_ptr<const RealFFTPlan<T>> get(int n);
+
+    /**
+     * @brief Size of the real signal.
+     */
+    int size() const;
+
+    /**
+     * @brief Forward transform of a real signal (unnormalized).
+     *
+     * @param in[] real signal of size() values
+     * @param out[] first size()/2+1 coefficients of its spectrum
+     */
+    void r2c(const T in[], std::complex<T> out[]) const;
+
+    /**
+     * @brief Inverse transform of a Hermitian spectrum (unnormalized).
+     * The imaginary parts of the coefficients that must be real (0 and, for even sizes, n/2) are ignored,
+     * so the result is the real part of the inverse of the Hermitian extension.
+     *
+     * @param in[] first size()/2+1 coefficients of the spectrum
+     * @param out[] real signal of size() values
+     */
+    void c2r(const std::complex<T> in[], T out[]) const;
+};
+
+#endif
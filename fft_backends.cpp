@@ -0,0 +1,241 @@
+#include "fft.hpp"
+#include <atomic>
+#include <unsupported/Eigen/FFT>
+
+#include <opencv2/core.hpp>
+
+
+// Default real transforms: complex transforms of size n
+
+template <typename T>
+static void r2cComplex(const FFTBackend &backend, const T in[], std::complex<T> out[], int n) {
+    thread_local std::vector<std::complex<T>> scratch;
+    scratch.resize(n);
+    for (int k = 0; k < n; k++) {
+        scratch[k] = std::complex<T>(in[k], 0);
+    }
+    backend.execute(scratch.data(), n, -1);
+    std::copy(scratch.begin(), scratch.begin() + n / 2 + 1, out);
+}
+
+template <typename T>
+static void c2rComplex(const FFTBackend &backend, const std::complex<T> in[], T out[], int n) {
+    /*Hermitian extension, the coefficients that must be real are made real*/
+    thread_local std::vector<std::complex<T>> scratch;
+    scratch.resize(n);
+    for (int k = 0; k <= n / 2; k++) {
+        scratch[k] = in[k];
+    }
+    for (int k = n / 2 + 1; k < n; k++) {
+        scratch[k] = std::conj(in[n - k]);
+    }
+    scratch[0].imag(0);
+    if (n % 2 == 0) {
+        scratch[n / 2].imag(0);
+    }
+    backend.execute(scratch.data(), n, 1);
+    for (int k = 0; k < n; k++) {
+        out[k] = scratch[k].real();
+    }
+}
+
+void FFTBackend::r2c(const float in[], std::complex<float> out[], int n) const {
+    r2cComplex(*this, in, out, n);
+}
+
+void FFTBackend::r2c(const double in[], std::complex<double> out[], int n) const {
+    r2cComplex(*this, in, out, n);
+}
+
+void FFTBackend::c2r(const std::complex<float> in[], float out[], int n) const {
+    c2rComplex(*this, in, out, n);
+}
+
+void FFTBackend::c2r(const std::complex<double> in[], double out[], int n) const {
+    c2rComplex(*this, in, out, n);
+}
+
+
+// In-house plans (FFTPlan, RealFFTPlan)
+
+/*the last plans used by the thread are kept, so that the signals of a batch do not look up the plan cache*/
+template <typename T>
+static const FFTPlan<T> &inHousePlan(int n, int dir) {
+    thread_local std::shared_ptr<const FFTPlan<T>> last;
+    if (!last || last->size() != n || last->direction() != dir) {
+        last = FFTPlan<T>::get(n, dir);
+    }
+    return *last;
+}
+
+template <typename T>
+static const RealFFTPlan<T> &inHouseRealPlan(int n) {
+    thread_local std::shared_ptr<const RealFFTPlan<T>> last;
+    if (!last || last->size() != n) {
+        last = RealFFTPlan<T>::get(n);
+    }
+    return *last;
+}
+
+class InHouseBackend : public FFTBackend {
+public:
+    const char *name() const override {
+        return "inhouse";
+    }
+
+    void execute(std::complex<float> data[], int n, int dir) const override {
+        inHousePlan<float>(n, dir).execute(data);
+    }
+
+    void execute(std::complex<double> data[], int n, int dir) const override {
+        inHousePlan<double>(n, dir).execute(data);
+    }
+
+    void r2c(const float in[], std::complex<float> out[], int n) const override {
+        inHouseRealPlan<float>(n).r2c(in, out);
+    }
+
+    void r2c(const double in[], std::complex<double> out[], int n) const override {
+        inHouseRealPlan<double>(n).r2c(in, out);
+    }
+
+    void c2r(const std::complex<float> in[], float out[], int n) const override {
+        inHouseRealPlan<float>(n).c2r(in, out);
+    }
+
+    void c2r(const std::complex<double> in[], double out[], int n) const override {
+        inHouseRealPlan<double>(n).c2r(in, out);
+    }
+};
+
+
+// Eigen (unsupported/Eigen/FFT, kissfft)
+
+/*Eigen::FFT keeps its plans and scratch buffers in the object, so every thread has its own*/
+template <typename T>
+static Eigen::FFT<T> &eigenFFT() {
+    thread_local Eigen::FFT<T> fft = [] {
+        Eigen::FFT<T> f;
+        f.SetFlag(Eigen::FFT<T>::Unscaled);
+        f.SetFlag(Eigen::FFT<T>::HalfSpectrum);
+        return f;
+    }();
+    return fft;
+}
+
+/*kissfft transforms out of place*/
+template <typename T>
+static void eigenExecute(std::complex<T> data[], int n, int dir) {
+    thread_local std::vector<std::complex<T>> scratch;
+    scratch.assign(data, data + n);
+    if (dir < 0) {
+        eigenFFT<T>().fwd(data, scratch.data(), n);
+    } else {
+        eigenFFT<T>().inv(data, scratch.data(), n);
+    }
+}
+
+template <typename T>
+static void eigenC2R(const std::complex<T> in[], T out[], int n) {
+    /*kissfft reads the imaginary parts of the coefficients that must be real for some sizes*/
+    thread_local std::vector<std::complex<T>> scratch;
+    scratch.assign(in, in + n / 2 + 1);
+    scratch[0].imag(0);
+    if (n % 2 == 0) {
+        scratch[n / 2].imag(0);
+    }
+    eigenFFT<T>().inv(out, scratch.data(), n);
+}
+
+class EigenBackend : public FFTBackend {
+public:
+    const char *name() const override {
+        return "eigen";
+    }
+
+    void execute(std::complex<float> data[], int n, int dir) const override {
+        eigenExecute(data, n, dir);
+    }
+
+    void execute(std::complex<double> data[], int n, int dir) const override {
+        eigenExecute(data, n, dir);
+    }
+
+    void r2c(const float in[], std::complex<float> out[], int n) const override {
+        eigenFFT<float>().fwd(out, in, n);
+    }
+
+    void r2c(const double in[], std::complex<double> out[], int n) const override {
+        eigenFFT<double>().fwd(out, in, n);
+    }
+
+    void c2r(const std::complex<float> in[], float out[], int n) const override {
+        eigenC2R(in, out, n);
+    }
+
+    void c2r(const std::complex<double> in[], double out[], int n) const override {
+        eigenC2R(in, out, n);
+    }
+};
+
+
+// OpenCV (cv::dft)
+
+class OpenCVBackend : public FFTBackend {
+public:
+    const char *name() const override {
+        return "opencv";
+    }
+
+    /*the complex values are viewed as a 1 x n two-channel matrix, transformed in place*/
+    void execute(std::complex<float> data[], int n, int dir) const override {
+        cv::Mat signal(1, n, CV_32FC2, data);
+        cv::dft(signal, signal, (dir > 0) ? cv::DFT_INVERSE : 0);
+    }
+
+    void execute(std::complex<double> data[], int n, int dir) const override {
+        cv::Mat signal(1, n, CV_64FC2, data);
+        cv::dft(signal, signal, (dir > 0) ? cv::DFT_INVERSE : 0);
+    }
+};
+
+
+// Backend table and selection
+
+static const InHouseBackend inHouseBackend;
+static const EigenBackend eigenBackend;
+static const OpenCVBackend openCVBackend;
+
+/*the in-house backend is first*/
+static const FFTBackend *const backends[] = {
+    &inHouseBackend,
+    &eigenBackend,
+    &openCVBackend,
+};
+
+static std::atomic<const FFTBackend *> &activeBackend() {
+    static std::atomic<const FFTBackend *> backend(backends[0]);
+    return backend;
+}
+
+const FFTBackend &fftBackend() {
+    return *activeBackend().load(std::memory_order_relaxed);
+}
+
+std::vector<std::string> availableFFTBackends() {
+    std::vector<std::string> names;
+    for (const FFTBackend *backend : backends) {
+        names.emplace_back(backend->name());
+    }
+    return names;
+}
+
+void setFFTBackend(const std::string &name) {
+    for (const FFTBackend *backend : backends) {
+        if (name == backend->name()) {
+            activeBackend().store(backend);
+            return;
+        }
+    }
+    throw std::invalid_argument("FFT backend " + name + " does not exist");
+}
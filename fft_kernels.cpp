@@ -0,0 +1,388 @@
+#include "fft.hpp"
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FFT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+// Radix-4 stages on split (SoA) arrays
+//
+// For every block of 4L values and j < L:
+//   t1 = w2 x1, t3 = w2 x3, b0 = x0 + t1, b1 = x0 - t1, b2 = w1 (x2 + t3), b3 = dir i w1 (x2 - t3)
+//   x0 = b0 + b2, x1 = b1 + b3, x2 = b0 - b2, x3 = b1 - b3
+// The vector kernels process one vector of consecutive values of j at once and require L to be a multiple
+// of the number of lanes (width floats or width / 2 doubles).
+
+template <typename T>
+static void radix4Scalar(T re[], T im[], int n, int L, const T w1re[], const T w1im[],
+                         const T w2re[], const T w2im[], int dir) {
+    const T sgn = T(dir);
+    for (int k = 0; k < n; k += 4 * L) {
+        T *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        T *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j++) {
+            T t1r = w2re[j] * r1[j] - w2im[j] * i1[j];
+            T t1i = w2re[j] * i1[j] + w2im[j] * r1[j];
+            T t3r = w2re[j] * r3[j] - w2im[j] * i3[j];
+            T t3i = w2re[j] * i3[j] + w2im[j] * r3[j];
+            T b0r = r0[j] + t1r, b0i = i0[j] + t1i;
+            T b1r = r0[j] - t1r, b1i = i0[j] - t1i;
+            T sr = r2[j] + t3r, si = i2[j] + t3i;
+            T dr = r2[j] - t3r, di = i2[j] - t3i;
+            T b2r = w1re[j] * sr - w1im[j] * si;
+            T b2i = w1re[j] * si + w1im[j] * sr;
+            T cr = w1re[j] * dr - w1im[j] * di;
+            T ci = w1re[j] * di + w1im[j] * dr;
+            T b3r = -sgn * ci, b3i = sgn * cr;
+            r0[j] = b0r + b2r; i0[j] = b0i + b2i;
+            r2[j] = b0r - b2r; i2[j] = b0i - b2i;
+            r1[j] = b1r + b3r; i1[j] = b1i + b3i;
+            r3[j] = b1r - b3r; i3[j] = b1i - b3i;
+        }
+    }
+}
+
+#ifdef FFT_X86_KERNELS
+
+__attribute__((target("sse2")))
+static void radix4SSE2Float(float re[], float im[], int n, int L, const float w1re[], const float w1im[],
+                            const float w2re[], const float w2im[], int dir) {
+    const __m128 sgn = _mm_set1_ps(float(dir));
+    for (int k = 0; k < n; k += 4 * L) {
+        float *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        float *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j += 4) {
+            __m128 wr2 = _mm_loadu_ps(w2re + j), wi2 = _mm_loadu_ps(w2im + j);
+            __m128 wr1 = _mm_loadu_ps(w1re + j), wi1 = _mm_loadu_ps(w1im + j);
+            __m128 x1r = _mm_loadu_ps(r1 + j), x1i = _mm_loadu_ps(i1 + j);
+            __m128 x3r = _mm_loadu_ps(r3 + j), x3i = _mm_loadu_ps(i3 + j);
+            __m128 t1r = _mm_sub_ps(_mm_mul_ps(wr2, x1r), _mm_mul_ps(wi2, x1i));
+            __m128 t1i = _mm_add_ps(_mm_mul_ps(wr2, x1i), _mm_mul_ps(wi2, x1r));
+            __m128 t3r = _mm_sub_ps(_mm_mul_ps(wr2, x3r), _mm_mul_ps(wi2, x3i));
+            __m128 t3i = _mm_add_ps(_mm_mul_ps(wr2, x3i), _mm_mul_ps(wi2, x3r));
+            __m128 x0r = _mm_loadu_ps(r0 + j), x0i = _mm_loadu_ps(i0 + j);
+            __m128 x2r = _mm_loadu_ps(r2 + j), x2i = _mm_loadu_ps(i2 + j);
+            __m128 b0r = _mm_add_ps(x0r, t1r), b0i = _mm_add_ps(x0i, t1i);
+            __m128 b1r = _mm_sub_ps(x0r, t1r), b1i = _mm_sub_ps(x0i, t1i);
+            __m128 sr = _mm_add_ps(x2r, t3r), si = _mm_add_ps(x2i, t3i);
+            __m128 dr = _mm_sub_ps(x2r, t3r), di = _mm_sub_ps(x2i, t3i);
+            __m128 b2r = _mm_sub_ps(_mm_mul_ps(wr1, sr), _mm_mul_ps(wi1, si));
+            __m128 b2i = _mm_add_ps(_mm_mul_ps(wr1, si), _mm_mul_ps(wi1, sr));
+            __m128 cr = _mm_sub_ps(_mm_mul_ps(wr1, dr), _mm_mul_ps(wi1, di));
+            __m128 ci = _mm_add_ps(_mm_mul_ps(wr1, di), _mm_mul_ps(wi1, dr));
+            __m128 b3r = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sgn, ci));
+            __m128 b3i = _mm_mul_ps(sgn, cr);
+            _mm_storeu_ps(r0 + j, _mm_add_ps(b0r, b2r));
+            _mm_storeu_ps(i0 + j, _mm_add_ps(b0i, b2i));
+            _mm_storeu_ps(r2 + j, _mm_sub_ps(b0r, b2r));
+            _mm_storeu_ps(i2 + j, _mm_sub_ps(b0i, b2i));
+            _mm_storeu_ps(r1 + j, _mm_add_ps(b1r, b3r));
+            _mm_storeu_ps(i1 + j, _mm_add_ps(b1i, b3i));
+            _mm_storeu_ps(r3 + j, _mm_sub_ps(b1r, b3r));
+            _mm_storeu_ps(i3 + j, _mm_sub_ps(b1i, b3i));
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static void radix4SSE2Double(double re[], double im[], int n, int L, const double w1re[], const double w1im[],
+                             const double w2re[], const double w2im[], int dir) {
+    const __m128d sgn = _mm_set1_pd(double(dir));
+    for (int k = 0; k < n; k += 4 * L) {
+        double *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        double *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j += 2) {
+            __m128d wr2 = _mm_loadu_pd(w2re + j), wi2 = _mm_loadu_pd(w2im + j);
+            __m128d wr1 = _mm_loadu_pd(w1re + j), wi1 = _mm_loadu_pd(w1im + j);
+            __m128d x1r = _mm_loadu_pd(r1 + j), x1i = _mm_loadu_pd(i1 + j);
+            __m128d x3r = _mm_loadu_pd(r3 + j), x3i = _mm_loadu_pd(i3 + j);
+            __m128d t1r = _mm_sub_pd(_mm_mul_pd(wr2, x1r), _mm_mul_pd(wi2, x1i));
+            __m128d t1i = _mm_add_pd(_mm_mul_pd(wr2, x1i), _mm_mul_pd(wi2, x1r));
+            __m128d t3r = _mm_sub_pd(_mm_mul_pd(wr2, x3r), _mm_mul_pd(wi2, x3i));
+            __m128d t3i = _mm_add_pd(_mm_mul_pd(wr2, x3i), _mm_mul_pd(wi2, x3r));
+            __m128d x0r = _mm_loadu_pd(r0 + j), x0i = _mm_loadu_pd(i0 + j);
+            __m128d x2r = _mm_loadu_pd(r2 + j), x2i = _mm_loadu_pd(i2 + j);
+            __m128d b0r = _mm_add_pd(x0r, t1r), b0i = _mm_add_pd(x0i, t1i);
+            __m128d b1r = _mm_sub_pd(x0r, t1r), b1i = _mm_sub_pd(x0i, t1i);
+            __m128d sr = _mm_add_pd(x2r, t3r), si = _mm_add_pd(x2i, t3i);
+            __m128d dr = _mm_sub_pd(x2r, t3r), di = _mm_sub_pd(x2i, t3i);
+            __m128d b2r = _mm_sub_pd(_mm_mul_pd(wr1, sr), _mm_mul_pd(wi1, si));
+            __m128d b2i = _mm_add_pd(_mm_mul_pd(wr1, si), _mm_mul_pd(wi1, sr));
+            __m128d cr = _mm_sub_pd(_mm_mul_pd(wr1, dr), _mm_mul_pd(wi1, di));
+            __m128d ci = _mm_add_pd(_mm_mul_pd(wr1, di), _mm_mul_pd(wi1, dr));
+            __m128d b3r = _mm_sub_pd(_mm_setzero_pd(), _mm_mul_pd(sgn, ci));
+            __m128d b3i = _mm_mul_pd(sgn, cr);
+            _mm_storeu_pd(r0 + j, _mm_add_pd(b0r, b2r));
+            _mm_storeu_pd(i0 + j, _mm_add_pd(b0i, b2i));
+            _mm_storeu_pd(r2 + j, _mm_sub_pd(b0r, b2r));
+            _mm_storeu_pd(i2 + j, _mm_sub_pd(b0i, b2i));
+            _mm_storeu_pd(r1 + j, _mm_add_pd(b1r, b3r));
+            _mm_storeu_pd(i1 + j, _mm_add_pd(b1i, b3i));
+            _mm_storeu_pd(r3 + j, _mm_sub_pd(b1r, b3r));
+            _mm_storeu_pd(i3 + j, _mm_sub_pd(b1i, b3i));
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void radix4AVX2Float(float re[], float im[], int n, int L, const float w1re[], const float w1im[],
+                            const float w2re[], const float w2im[], int dir) {
+    const __m256 sgn = _mm256_set1_ps(float(dir));
+    for (int k = 0; k < n; k += 4 * L) {
+        float *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        float *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j += 8) {
+            __m256 wr2 = _mm256_loadu_ps(w2re + j), wi2 = _mm256_loadu_ps(w2im + j);
+            __m256 wr1 = _mm256_loadu_ps(w1re + j), wi1 = _mm256_loadu_ps(w1im + j);
+            __m256 x1r = _mm256_loadu_ps(r1 + j), x1i = _mm256_loadu_ps(i1 + j);
+            __m256 x3r = _mm256_loadu_ps(r3 + j), x3i = _mm256_loadu_ps(i3 + j);
+            __m256 t1r = _mm256_fmsub_ps(wr2, x1r, _mm256_mul_ps(wi2, x1i));
+            __m256 t1i = _mm256_fmadd_ps(wr2, x1i, _mm256_mul_ps(wi2, x1r));
+            __m256 t3r = _mm256_fmsub_ps(wr2, x3r, _mm256_mul_ps(wi2, x3i));
+            __m256 t3i = _mm256_fmadd_ps(wr2, x3i, _mm256_mul_ps(wi2, x3r));
+            __m256 x0r = _mm256_loadu_ps(r0 + j), x0i = _mm256_loadu_ps(i0 + j);
+            __m256 x2r = _mm256_loadu_ps(r2 + j), x2i = _mm256_loadu_ps(i2 + j);
+            __m256 b0r = _mm256_add_ps(x0r, t1r), b0i = _mm256_add_ps(x0i, t1i);
+            __m256 b1r = _mm256_sub_ps(x0r, t1r), b1i = _mm256_sub_ps(x0i, t1i);
+            __m256 sr = _mm256_add_ps(x2r, t3r), si = _mm256_add_ps(x2i, t3i);
+            __m256 dr = _mm256_sub_ps(x2r, t3r), di = _mm256_sub_ps(x2i, t3i);
+            __m256 b2r = _mm256_fmsub_ps(wr1, sr, _mm256_mul_ps(wi1, si));
+            __m256 b2i = _mm256_fmadd_ps(wr1, si, _mm256_mul_ps(wi1, sr));
+            __m256 cr = _mm256_fmsub_ps(wr1, dr, _mm256_mul_ps(wi1, di));
+            __m256 ci = _mm256_fmadd_ps(wr1, di, _mm256_mul_ps(wi1, dr));
+            __m256 b3r = _mm256_fnmadd_ps(sgn, ci, _mm256_setzero_ps());
+            __m256 b3i = _mm256_mul_ps(sgn, cr);
+            _mm256_storeu_ps(r0 + j, _mm256_add_ps(b0r, b2r));
+            _mm256_storeu_ps(i0 + j, _mm256_add_ps(b0i, b2i));
+            _mm256_storeu_ps(r2 + j, _mm256_sub_ps(b0r, b2r));
+            _mm256_storeu_ps(i2 + j, _mm256_sub_ps(b0i, b2i));
+            _mm256_storeu_ps(r1 + j, _mm256_add_ps(b1r, b3r));
+            _mm256_storeu_ps(i1 + j, _mm256_add_ps(b1i, b3i));
+            _mm256_storeu_ps(r3 + j, _mm256_sub_ps(b1r, b3r));
+            _mm256_storeu_ps(i3 + j, _mm256_sub_ps(b1i, b3i));
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void radix4AVX2Double(double re[], double im[], int n, int L, const double w1re[], const double w1im[],
+                             const double w2re[], const double w2im[], int dir) {
+    const __m256d sgn = _mm256_set1_pd(double(dir));
+    for (int k = 0; k < n; k += 4 * L) {
+        double *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        double *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j += 4) {
+            __m256d wr2 = _mm256_loadu_pd(w2re + j), wi2 = _mm256_loadu_pd(w2im + j);
+            __m256d wr1 = _mm256_loadu_pd(w1re + j), wi1 = _mm256_loadu_pd(w1im + j);
+            __m256d x1r = _mm256_loadu_pd(r1 + j), x1i = _mm256_loadu_pd(i1 + j);
+            __m256d x3r = _mm256_loadu_pd(r3 + j), x3i = _mm256_loadu_pd(i3 + j);
+            __m256d t1r = _mm256_fmsub_pd(wr2, x1r, _mm256_mul_pd(wi2, x1i));
+            __m256d t1i = _mm256_fmadd_pd(wr2, x1i, _mm256_mul_pd(wi2, x1r));
+            __m256d t3r = _mm256_fmsub_pd(wr2, x3r, _mm256_mul_pd(wi2, x3i));
+            __m256d t3i = _mm256_fmadd_pd(wr2, x3i, _mm256_mul_pd(wi2, x3r));
+            __m256d x0r = _mm256_loadu_pd(r0 + j), x0i = _mm256_loadu_pd(i0 + j);
+            __m256d x2r = _mm256_loadu_pd(r2 + j), x2i = _mm256_loadu_pd(i2 + j);
+            __m256d b0r = _mm256_add_pd(x0r, t1r), b0i = _mm256_add_pd(x0i, t1i);
+            __m256d b1r = _mm256_sub_pd(x0r, t1r), b1i = _mm256_sub_pd(x0i, t1i);
+            __m256d sr = _mm256_add_pd(x2r, t3r), si = _mm256_add_pd(x2i, t3i);
+            __m256d dr = _mm256_sub_pd(x2r, t3r), di = _mm256_sub_pd(x2i, t3i);
+            __m256d b2r = _mm256_fmsub_pd(wr1, sr, _mm256_mul_pd(wi1, si));
+            __m256d b2i = _mm256_fmadd_pd(wr1, si, _mm256_mul_pd(wi1, sr));
+            __m256d cr = _mm256_fmsub_pd(wr1, dr, _mm256_mul_pd(wi1, di));
+            __m256d ci = _mm256_fmadd_pd(wr1, di, _mm256_mul_pd(wi1, dr));
+            __m256d b3r = _mm256_fnmadd_pd(sgn, ci, _mm256_setzero_pd());
+            __m256d b3i = _mm256_mul_pd(sgn, cr);
+            _mm256_storeu_pd(r0 + j, _mm256_add_pd(b0r, b2r));
+            _mm256_storeu_pd(i0 + j, _mm256_add_pd(b0i, b2i));
+            _mm256_storeu_pd(r2 + j, _mm256_sub_pd(b0r, b2r));
+            _mm256_storeu_pd(i2 + j, _mm256_sub_pd(b0i, b2i));
+            _mm256_storeu_pd(r1 + j, _mm256_add_pd(b1r, b3r));
+            _mm256_storeu_pd(i1 + j, _mm256_add_pd(b1i, b3i));
+            _mm256_storeu_pd(r3 + j, _mm256_sub_pd(b1r, b3r));
+            _mm256_storeu_pd(i3 + j, _mm256_sub_pd(b1i, b3i));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void radix4AVX512Float(float re[], float im[], int n, int L, const float w1re[], const float w1im[],
+                              const float w2re[], const float w2im[], int dir) {
+    const __m512 sgn = _mm512_set1_ps(float(dir));
+    for (int k = 0; k < n; k += 4 * L) {
+        float *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        float *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j += 16) {
+            __m512 wr2 = _mm512_loadu_ps(w2re + j), wi2 = _mm512_loadu_ps(w2im + j);
+            __m512 wr1 = _mm512_loadu_ps(w1re + j), wi1 = _mm512_loadu_ps(w1im + j);
+            __m512 x1r = _mm512_loadu_ps(r1 + j), x1i = _mm512_loadu_ps(i1 + j);
+            __m512 x3r = _mm512_loadu_ps(r3 + j), x3i = _mm512_loadu_ps(i3 + j);
+            __m512 t1r = _mm512_fmsub_ps(wr2, x1r, _mm512_mul_ps(wi2, x1i));
+            __m512 t1i = _mm512_fmadd_ps(wr2, x1i, _mm512_mul_ps(wi2, x1r));
+            __m512 t3r = _mm512_fmsub_ps(wr2, x3r, _mm512_mul_ps(wi2, x3i));
+            __m512 t3i = _mm512_fmadd_ps(wr2, x3i, _mm512_mul_ps(wi2, x3r));
+            __m512 x0r = _mm512_loadu_ps(r0 + j), x0i = _mm512_loadu_ps(i0 + j);
+            __m512 x2r = _mm512_loadu_ps(r2 + j), x2i = _mm512_loadu_ps(i2 + j);
+            __m512 b0r = _mm512_add_ps(x0r, t1r), b0i = _mm512_add_ps(x0i, t1i);
+            __m512 b1r = _mm512_sub_ps(x0r, t1r), b1i = _mm512_sub_ps(x0i, t1i);
+            __m512 sr = _mm512_add_ps(x2r, t3r), si = _mm512_add_ps(x2i, t3i);
+            __m512 dr = _mm512_sub_ps(x2r, t3r), di = _mm512_sub_ps(x2i, t3i);
+            __m512 b2r = _mm512_fmsub_ps(wr1, sr, _mm512_mul_ps(wi1, si));
+            __m512 b2i = _mm512_fmadd_ps(wr1, si, _mm512_mul_ps(wi1, sr));
+            __m512 cr = _mm512_fmsub_ps(wr1, dr, _mm512_mul_ps(wi1, di));
+            __m512 ci = _mm512_fmadd_ps(wr1, di, _mm512_mul_ps(wi1, dr));
+            __m512 b3r = _mm512_fnmadd_ps(sgn, ci, _mm512_setzero_ps());
+            __m512 b3i = _mm512_mul_ps(sgn, cr);
+            _mm512_storeu_ps(r0 + j, _mm512_add_ps(b0r, b2r));
+            _mm512_storeu_ps(i0 + j, _mm512_add_ps(b0i, b2i));
+            _mm512_storeu_ps(r2 + j, _mm512_sub_ps(b0r, b2r));
+            _mm512_storeu_ps(i2 + j, _mm512_sub_ps(b0i, b2i));
+            _mm512_storeu_ps(r1 + j, _mm512_add_ps(b1r, b3r));
+            _mm512_storeu_ps(i1 + j, _mm512_add_ps(b1i, b3i));
+            _mm512_storeu_ps(r3 + j, _mm512_sub_ps(b1r, b3r));
+            _mm512_storeu_ps(i3 + j, _mm512_sub_ps(b1i, b3i));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void radix4AVX512Double(double re[], double im[], int n, int L, const double w1re[], const double w1im[],
+                               const double w2re[], const double w2im[], int dir) {
+    const __m512d sgn = _mm512_set1_pd(double(dir));
+    for (int k = 0; k < n; k += 4 * L) {
+        double *r0 = re + k, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+        double *i0 = im + k, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+        for (int j = 0; j < L; j += 8) {
+            __m512d wr2 = _mm512_loadu_pd(w2re + j), wi2 = _mm512_loadu_pd(w2im + j);
+            __m512d wr1 = _mm512_loadu_pd(w1re + j), wi1 = _mm512_loadu_pd(w1im + j);
+            __m512d x1r = _mm512_loadu_pd(r1 + j), x1i = _mm512_loadu_pd(i1 + j);
+            __m512d x3r = _mm512_loadu_pd(r3 + j), x3i = _mm512_loadu_pd(i3 + j);
+            __m512d t1r = _mm512_fmsub_pd(wr2, x1r, _mm512_mul_pd(wi2, x1i));
+            __m512d t1i = _mm512_fmadd_pd(wr2, x1i, _mm512_mul_pd(wi2, x1r));
+            __m512d t3r = _mm512_fmsub_pd(wr2, x3r, _mm512_mul_pd(wi2, x3i));
+            __m512d t3i = _mm512_fmadd_pd(wr2, x3i, _mm512_mul_pd(wi2, x3r));
+            __m512d x0r = _mm512_loadu_pd(r0 + j), x0i = _mm512_loadu_pd(i0 + j);
+            __m512d x2r = _mm512_loadu_pd(r2 + j), x2i = _mm512_loadu_pd(i2 + j);
+            __m512d b0r = _mm512_add_pd(x0r, t1r), b0i = _mm512_add_pd(x0i, t1i);
+            __m512d b1r = _mm512_sub_pd(x0r, t1r), b1i = _mm512_sub_pd(x0i, t1i);
+            __m512d sr = _mm512_add_pd(x2r, t3r), si = _mm512_add_pd(x2i, t3i);
+            __m512d dr = _mm512_sub_pd(x2r, t3r), di = _mm512_sub_pd(x2i, t3i);
+            __m512d b2r = _mm512_fmsub_pd(wr1, sr, _mm512_mul_pd(wi1, si));
+            __m512d b2i = _mm512_fmadd_pd(wr1, si, _mm512_mul_pd(wi1, sr));
+            __m512d cr = _mm512_fmsub_pd(wr1, dr, _mm512_mul_pd(wi1, di));
+            __m512d ci = _mm512_fmadd_pd(wr1, di, _mm512_mul_pd(wi1, dr));
+            __m512d b3r = _mm512_fnmadd_pd(sgn, ci, _mm512_setzero_pd());
+            __m512d b3i = _mm512_mul_pd(sgn, cr);
+            _mm512_storeu_pd(r0 + j, _mm512_add_pd(b0r, b2r));
+            _mm512_storeu_pd(i0 + j, _mm512_add_pd(b0i, b2i));
+            _mm512_storeu_pd(r2 + j, _mm512_sub_pd(b0r, b2r));
+            _mm512_storeu_pd(i2 + j, _mm512_sub_pd(b0i, b2i));
+            _mm512_storeu_pd(r1 + j, _mm512_add_pd(b1r, b3r));
+            _mm512_storeu_pd(i1 + j, _mm512_add_pd(b1i, b3i));
+            _mm512_storeu_pd(r3 + j, _mm512_sub_pd(b1r, b3r));
+            _mm512_storeu_pd(i3 + j, _mm512_sub_pd(b1i, b3i));
+        }
+    }
+}
+
+#endif
+
+
+// Kernel table and runtime dispatch
+
+static bool alwaysSupported() {
+    return true;
+}
+
+#ifdef FFT_X86_KERNELS
+static bool sse2Supported() {
+    return __builtin_cpu_supports("sse2");
+}
+
+static bool avx2Supported() {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool avx512Supported() {
+    return __builtin_cpu_supports("avx512f");
+}
+#endif
+
+/*ordered from the widest to the narrowest, the scalar kernel is always last*/
+static const FFTKernel kernels[] = {
+#ifdef FFT_X86_KERNELS
+    {"avx512", 16, avx512Supported, radix4AVX512Float, radix4AVX512Double},
+    {"avx2", 8, avx2Supported, radix4AVX2Float, radix4AVX2Double},
+    {"sse2", 4, sse2Supported, radix4SSE2Float, radix4SSE2Double},
+#endif
+    {"scalar", 1, alwaysSupported, radix4Scalar<float>, radix4Scalar<double>},
+};
+
+static const FFTKernel *detectKernel() {
+    for (const auto &kernel : kernels) {
+        if (kernel.supported()) {
+            return &kernel;
+        }
+    }
+    return &kernels[0];
+}
+
+static std::atomic<const FFTKernel *> &activeKernel() {
+    static std::atomic<const FFTKernel *> kernel(detectKernel());
+    return kernel;
+}
+
+const FFTKernel &fftKernel() {
+    return *activeKernel().load(std::memory_order_relaxed);
+}
+
+const FFTKernel &fftScalarKernel() {
+    return kernels[sizeof(kernels) / sizeof(kernels[0]) - 1];
+}
+
+std::string fftKernelName() {
+    return fftKernel().name;
+}
+
+std::vector<std::string> availableFFTKernels() {
+    std::vector<std::string> names;
+    for (const auto &kernel : kernels) {
+        if (kernel.supported()) {
+            names.emplace_back(kernel.name);
+        }
+    }
+    return names;
+}
+
+const FFTKernel &findFFTKernel(const std::string &name) {
+    for (const auto &kernel : kernels) {
+        if (name == kernel.name && kernel.supported()) {
+            return kernel;
+        }
+    }
+    throw std::invalid_argument("FFT kernel " + name + " is not available on this CPU");
+}
+
+void setFFTKernel(const std::string &name) {
+    activeKernel().store(&findFFTKernel(name));
+}
+
+std::string fftCPUFeatures() {
+    std::string features;
+#ifdef FFT_X86_KERNELS
+    if (__builtin_cpu_supports("sse2")) {
+        features += "sse2+";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        features += "avx2+";
+    }
+    if (__builtin_cpu_supports("fma")) {
+        features += "fma+";
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        features += "avx512f+";
+    }
+#endif
+    return features.empty() ? "generic" : features.substr(0, features.size() - 1);
+}
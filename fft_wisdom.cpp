@@ -0,0 +1,160 @@
+#include "fft.hpp"
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+
+// Wisdom file
+//
+// One plan per line, fields separated by spaces (lines starting with # are comments):
+//   features precision size direction strategy kernel radices
+// e.g. "sse2+avx2+fma float 1024 -1 radix2 avx2 -" or "sse2+avx2+fma double 60 -1 mixed - 4,3,5".
+// An empty kernel or radix list is written as "-".
+
+/*features, precision, size, direction*/
+typedef std::tuple<std::string, std::string, int, int> WisdomKey;
+
+namespace {
+
+struct WisdomState {
+    std::mutex mutex;
+    std::map<WisdomKey, FFTPlanChoice> entries;
+    std::string features = fftCPUFeatures();
+    bool modified = false;
+    bool autotune = false;
+};
+
+}
+
+static WisdomState &wisdom() {
+    static WisdomState state;
+    return state;
+}
+
+static const char *strategyNames[] = {"radix2", "mixed", "bluestein"};
+
+bool FFTWisdom::lookup(int n, int dir, const std::string &precision, FFTPlanChoice &choice) {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto found = state.entries.find(WisdomKey(state.features, precision, n, dir));
+    if (found == state.entries.end()) {
+        return false;
+    }
+    choice = found->second;
+    return true;
+}
+
+void FFTWisdom::record(int n, int dir, const std::string &precision, const FFTPlanChoice &choice) {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.entries[WisdomKey(state.features, precision, n, dir)] = choice;
+    state.modified = true;
+}
+
+bool FFTWisdom::load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    /*parse the whole file before merging, so that a malformed file leaves the wisdom unchanged*/
+    WisdomState &state = wisdom();
+    std::map<WisdomKey, FFTPlanChoice> loaded;
+    std::string line;
+    for (int number = 1; std::getline(file, line); number++) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string features, precision, strategy, kernel, radices;
+        int n, dir;
+        if (!(fields >> features >> precision >> n >> dir >> strategy >> kernel >> radices)) {
+            throw std::invalid_argument("Malformed wisdom file " + path + " at line " + std::to_string(number));
+        }
+
+        FFTPlanChoice choice;
+        int s = 0;
+        while (s < 3 && strategy != strategyNames[s]) {
+            s++;
+        }
+        if (s == 3 || (precision != "float" && precision != "double")) {
+            throw std::invalid_argument("Malformed wisdom file " + path + " at line " + std::to_string(number));
+        }
+        choice.strategy = FFTPlanChoice::Strategy(s);
+        if (kernel != "-") {
+            choice.kernel = kernel;
+        }
+        if (radices != "-") {
+            std::istringstream list(radices);
+            std::string radix;
+            while (std::getline(list, radix, ',')) {
+                choice.radices.push_back(std::atoi(radix.c_str()));
+            }
+        }
+
+        /*the kernels of other CPUs cannot be checked here*/
+        if (features == state.features && !choice.valid(n)) {
+            throw std::invalid_argument("Invalid plan in wisdom file " + path + " at line " + std::to_string(number));
+        }
+        loaded[WisdomKey(features, precision, n, dir)] = choice;
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (const auto &entry : loaded) {
+        state.entries[entry.first] = entry.second;
+    }
+    state.modified = false;
+    return true;
+}
+
+void FFTWisdom::save(const std::string &path) {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::invalid_argument("Cannot write wisdom file " + path);
+    }
+
+    file << "# FFT wisdom: features precision size direction strategy kernel radices\n";
+    for (const auto &entry : state.entries) {
+        const FFTPlanChoice &choice = entry.second;
+        std::string radices;
+        for (int r : choice.radices) {
+            radices += (radices.empty() ? "" : ",") + std::to_string(r);
+        }
+        file << std::get<0>(entry.first) << " " << std::get<1>(entry.first) << " "
+             << std::get<2>(entry.first) << " " << std::get<3>(entry.first) << " "
+             << strategyNames[choice.strategy] << " "
+             << (choice.kernel.empty() ? "-" : choice.kernel) << " "
+             << (radices.empty() ? "-" : radices) << "\n";
+    }
+    state.modified = false;
+}
+
+void FFTWisdom::clear() {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.entries.clear();
+    state.modified = false;
+}
+
+bool FFTWisdom::modified() {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.modified;
+}
+
+void FFTWisdom::setAutotune(bool enabled) {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.autotune = enabled;
+}
+
+bool FFTWisdom::autotune() {
+    WisdomState &state = wisdom();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.autotune;
+}
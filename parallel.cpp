@@ -0,0 +1,126 @@
+#include "parallel.hpp"
+
+
+/*set in the threads running a chunk, loops started from there run serially*/
+static thread_local bool insideLoop = false;
+
+
+// ThreadPool
+
+ThreadPool::ThreadPool(int nthreads) {
+    start(nthreads);
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start(int nthreads) {
+    if (nthreads <= 0) {
+        nthreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    stopping = false;
+    for (int i = 1; i < nthreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i, generation);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::resize(int nthreads) {
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+    stop();
+    start(nthreads);
+}
+
+int ThreadPool::size() const {
+    return int(workers.size()) + 1;
+}
+
+void ThreadPool::runChunk(int worker) {
+    long long len = loopEnd - loopBegin;
+    int chunkBegin = loopBegin + int(len * worker / size());
+    int chunkEnd = loopBegin + int(len * (worker + 1) / size());
+    if (chunkBegin >= chunkEnd) {
+        return;
+    }
+    insideLoop = true;
+    try {
+        (*body)(chunkBegin, chunkEnd, worker);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+    }
+    insideLoop = false;
+}
+
+void ThreadPool::workerLoop(int worker, int seen) {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        lock.unlock();
+
+        runChunk(worker);
+
+        lock.lock();
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, LoopBody body_) {
+    if (begin >= end) {
+        return;
+    }
+    if (workers.empty() || insideLoop || end - begin == 1) {
+        body_(begin, end, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = &body_;
+        loopBegin = begin;
+        loopEnd = end;
+        pending = int(workers.size());
+        error = nullptr;
+        generation++;
+    }
+    wakeUp.notify_all();
+
+    runChunk(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return pending == 0; });
+    body = nullptr;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::setGlobalThreads(int nthreads) {
+    global().resize(nthreads);
+}
@@ -0,0 +1,108 @@
+#ifndef PARALLEL
+#define PARALLEL
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+
+/**
+ * @brief Non-owning reference to the body of a parallel loop, called as body(chunk_begin, chunk_end, thread_index).
+ * Unlike std::function it neither copies nor allocates, so that a loop costs no heap allocation;
+ * the referenced callable must outlive the loop (e.g. a lambda passed to parallelFor).
+ */
+class LoopBody {
+private:
+    const void* callable; /// the referenced callable
+    void (*invoke)(const void*, int, int, int); /// calls the callable with its actual type
+
+public:
+    template <typename F>
+    LoopBody(const F& f) : callable(&f), invoke([](const void* c, int begin, int end, int thread) {
+        (*static_cast<const F*>(c))(begin, end, thread);
+    }) {}
+
+    void operator()(int begin, int end, int thread) const {
+        invoke(callable, begin, end, thread);
+    }
+};
+
+
+/**
+ * @brief Fixed-size pool of worker threads running parallel loops.
+ * The pool keeps its threads alive between loops, so a parallel loop costs a wake-up
+ * instead of thread creation. Loops started from inside a worker run serially.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers; /// worker threads (the calling thread is used as well)
+    std::mutex mutex; /// protects the fields below
+    std::condition_variable wakeUp; /// signals a new loop (or the shutdown) to the workers
+    std::condition_variable done; /// signals the end of a chunk to the calling thread
+    const LoopBody* body = nullptr; /// body of the current loop
+    int loopBegin = 0, loopEnd = 0; /// range of the current loop
+    int generation = 0; /// incremented for every loop
+    int pending = 0; /// number of chunks of the current loop not yet finished
+    bool stopping = false; /// flag if the pool is being destroyed
+    std::exception_ptr error; /// first exception thrown by a chunk of the current loop
+    std::mutex loopMutex; /// serializes the loops of different calling threads
+
+    void workerLoop(int worker, int seen);
+    void runChunk(int worker);
+    void start(int nthreads);
+    void stop();
+
+public:
+    /**
+     * @brief Construct a new pool.
+     *
+     * @param nthreads Total number of threads running a loop, including the calling thread
+     * (0 = number of hardware threads)
+     */
+    explicit ThreadPool(int nthreads = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Total number of threads running a loop, including the calling thread.
+     */
+    int size() const;
+
+    /**
+     * @brief Run body(chunk_begin, chunk_end, thread_index) over [begin, end) split into size() contiguous chunks.
+     * Returns when all chunks are finished. thread_index < size() can be used to select per-thread scratch memory.
+     *
+     * @param begin First index of the loop
+     * @param end Past-the-end index of the loop
+     * @param body_ Body of the loop
+     */
+    void parallelFor(int begin, int end, LoopBody body_);
+
+    /**
+     * @brief Change the number of threads (must not be called while the pool runs a loop).
+     *
+     * @param nthreads Total number of threads (0 = number of hardware threads, 1 = serial)
+     */
+    void resize(int nthreads);
+
+    /**
+     * @brief Pool shared by the transforms.
+     */
+    static ThreadPool& global();
+
+    /**
+     * @brief Resize the pool shared by the transforms (must not be called while it runs a loop).
+     *
+     * @param nthreads Total number of threads (0 = number of hardware threads, 1 = serial)
+     */
+    static void setGlobalThreads(int nthreads);
+};
+
+#endif
@@ -12,7 +12,17 @@ void parse_cl_input(int argc, const char* argv[]) {
         make_shared<FFT2DMagParser>(),
         make_shared<iFFT2DParser>(),
         make_shared<HighpassFilterParser>(),
-        make_shared<LowpassFilterParser>()
+        make_shared<LowpassFilterParser>(),
+        make_shared<FrequencyFilterParser>(FilterSpec::GaussianLowpass),
+        make_shared<FrequencyFilterParser>(FilterSpec::GaussianHighpass),
+        make_shared<FrequencyFilterParser>(FilterSpec::ButterworthLowpass),
+        make_shared<FrequencyFilterParser>(FilterSpec::ButterworthHighpass),
+        make_shared<FrequencyFilterParser>(FilterSpec::Bandpass),
+        make_shared<FrequencyFilterParser>(FilterSpec::Notch),
+        make_shared<LUTParser>(LUTParser::Gamma),
+        make_shared<LUTParser>(LUTParser::Stretch),
+        make_shared<LUTParser>(LUTParser::Equalize),
+        make_shared<ChainParser>()
     };
     // todo: pass as an argument?
     
@@ -32,12 +42,45 @@ void parse_cl_input(int argc, const char* argv[]) {
                 if (opt_str == parser->get_name()) {
                     cout << "found " << parser->get_name() << "\n";
 
+                    /*--fft-backend=<name> and --fft-autotune can be given anywhere after the transform name*/
+                    const string BACKEND_OPT = "--fft-backend=";
+                    const string AUTOTUNE_OPT = "--fft-autotune";
+                    bool autotune = false;
                     vector<string> arg_vec;
                     for (int i = 2; i < argc; ++i) {
-                        arg_vec.emplace_back(argv[i]);
+                        string arg(argv[i]);
+                        if (arg.compare(0, BACKEND_OPT.size(), BACKEND_OPT) == 0) {
+                            setFFTBackend(arg.substr(BACKEND_OPT.size()));
+                        } else if (arg == AUTOTUNE_OPT) {
+                            autotune = true;
+                        } else {
+                            arg_vec.emplace_back(arg);
+                        }
                     }
-                    
+                    cout << "FFT backend: " << fftBackend().name() << ", kernel: " << fftKernelName() << "\n";
+
+
+                    /*plans tuned by a previous run are reused, new sizes are only tuned (and saved) on request*/
+                    const char *wisdom_env = std::getenv("FFT_WISDOM");
+                    string wisdom_path = wisdom_env ? wisdom_env : "fft_wisdom.txt";
+                    try {
+                        FFTWisdom::load(wisdom_path);
+                    } catch (const std::invalid_argument& err) {
+                        /*the wisdom is only a cache of tuned plans: run without it, plans tuned with --fft-autotune replace the file*/
+                        cout << "Ignoring the FFT wisdom: " << err.what() << "\n";
+                    }
+                    FFTWisdom::setAutotune(autotune);
+
                     parser->apply(arg_vec);
+
+                    if (FFTWisdom::modified()) {
+                        try {
+                            FFTWisdom::save(wisdom_path);
+                        } catch (const std::invalid_argument& err) {
+                            /*the output is already written, the tuned plans are only lost for the next runs*/
+                            cout << "FFT wisdom not saved: " << err.what() << "\n";
+                        }
+                    }
                     break;
                 }
             }
@@ -81,7 +124,7 @@ ThresholdingParser::ThresholdingParser() {
     name = "threshold";
 }
 
-Transform<MatrixXi, MatrixXi>* ThresholdingParser::parse(const vector<string>& arguments) {
+Transform<MatrixXu8, MatrixXu8>* ThresholdingParser::parse(const vector<string>& arguments) {
     cout << "n_args = " << arguments.size() << "\n";
 
     if (arguments.size() != 2 + arg_num)
@@ -91,7 +134,7 @@ Transform<MatrixXi, MatrixXi>* ThresholdingParser::parse(const vector<string>& a
     int thr_min = std::stoi(arguments[2]);
     int thr_max = std::stoi(arguments[3]);
 
-    return new Thresholding(thr_min, thr_max);
+    return new Thresholding<uint8_t>(thr_min, thr_max);
 }
 
 void ThresholdingParser::apply(const vector <string>& arguments) {
@@ -102,9 +145,9 @@ void ThresholdingParser::apply(const vector <string>& arguments) {
     string inp_fname = glob_path + arguments[0];
     string out_fname = glob_path + arguments[1];
 
-    MatrixXi input = readIntMatrix(inp_fname);
-    auto thresh = parse(arguments);
-    MatrixXi output = thresh->transform(input);
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    std::unique_ptr<Transform<MatrixXu8, MatrixXu8>> thresh(parse(arguments));
+    MatrixXu8 output = thresh->transform(input);
     writeIntMatrix(out_fname, output);
 }
 
@@ -116,12 +159,12 @@ HistogramParser::HistogramParser() {
     name = "histogram";
 }
 
-Transform<MatrixXi, MatrixXd>* HistogramParser::parse(const vector<string>& arguments) {
+Transform<MatrixXu8, MatrixXd>* HistogramParser::parse(const vector<string>& arguments) {
     cout << "n_args = " << arguments.size() << "\n";
 
     if (arguments.size() != 2 + arg_num)
         throw std::invalid_argument("Histogram requires no arguments.");
-    return new Histogram();
+    return new Histogram<uint8_t>();
 }
 
 void HistogramParser::apply(const vector<string> &arguments) {
@@ -129,9 +172,9 @@ void HistogramParser::apply(const vector<string> &arguments) {
     string glob_path = std::experimental::filesystem::current_path();
     string inp_fname = glob_path + arguments[0];
     string out_fname = glob_path + arguments[1];
-    MatrixXi input = readIntMatrix(inp_fname);
-    auto thresh = parse(arguments);
-    MatrixXd output = thresh ->transform(input);
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    std::unique_ptr<Transform<MatrixXu8, MatrixXd>> thresh(parse(arguments));
+    MatrixXd output = thresh->transform(input);
     writeDoubleMatrix(out_fname, output);
 }
 
@@ -170,8 +213,8 @@ void FFT2DFreqParser::apply(const vector<string> &arguments) {
     string inp_fname = glob_path + arguments[0];
     string out_fname = glob_path + arguments[1];
     MatrixXi input = readIntMatrix(inp_fname);
-    auto thresh = parse(arguments);
-    Eigen::Matrix<std::complex<double>,-1, -1> output = thresh ->transform(input);
+    std::unique_ptr<Transform<MatrixXi, Eigen::Matrix<std::complex<double>,-1, -1>>> thresh(parse(arguments));
+    Eigen::Matrix<std::complex<double>,-1, -1> output = thresh->transform(input);
     writeComplexMatrix(out_fname, output);
 }
 
@@ -180,7 +223,7 @@ FFT2DMagParser::FFT2DMagParser() {
     name = "fft2Dmag";
 }
 
-FFT2D* FFT2DMagParser::parse(const vector<string>& arguments){
+FFT2D<>* FFT2DMagParser::parse(const vector<string>& arguments){
     cout << "n_args = " << arguments.size() << "\n";
     if (arguments.size() == 2 + arg_num){
         int fftstep = std::stoi(arguments[2]);
@@ -206,10 +249,9 @@ void FFT2DMagParser::apply(const vector<string> &arguments) {
     string inp_fname = glob_path + arguments[0];
     string out_fname = glob_path + arguments[1];
     MatrixXi input = readIntMatrix(inp_fname);
-    auto thresh = parse(arguments);
-    thresh->transform(input);
-    Eigen::Matrix<std::complex<double>,-1, -1> output = thresh ->getMagnitude();
-    writeComplexMatrix(out_fname, output);
+    std::unique_ptr<FFT2D<>> thresh(parse(arguments));
+    MatrixXd output = FFT2D<>::getMagnitude(thresh->transform(input));
+    writeDoubleMatrix(out_fname, output);
 }
 
 
@@ -252,7 +294,7 @@ HighpassFilterParser::HighpassFilterParser(){
     name = "highpass";
 }
 
-Transform<MatrixXi, MatrixXi>* HighpassFilterParser::parse(const vector<string>& arguments) {
+Transform<MatrixXu8, MatrixXu8>* HighpassFilterParser::parse(const vector<string>& arguments) {
     cout << "n_args = " << arguments.size() << "\n";
 
     if (arguments.size() != 2 + arg_num)
@@ -260,7 +302,7 @@ Transform<MatrixXi, MatrixXi>* HighpassFilterParser::parse(const vector<string>&
 
     // throws an exception if not convertible to int
     int thr_high = std::stoi(arguments[2]);
-    return new HighpassFilter(thr_high);
+    return new HighpassFilter<double, uint8_t>(thr_high);
 }
 
 void HighpassFilterParser::apply(const vector <string>& arguments) {
@@ -270,9 +312,9 @@ void HighpassFilterParser::apply(const vector <string>& arguments) {
     string inp_fname = glob_path + arguments[0];
     string out_fname = glob_path + arguments[1];
 
-    MatrixXi input = readIntMatrix(inp_fname);
-    auto thresh = parse(arguments);
-    MatrixXi output = thresh->transform(input);
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    std::unique_ptr<Transform<MatrixXu8, MatrixXu8>> thresh(parse(arguments));
+    MatrixXu8 output = thresh->transform(input);
     writeIntMatrix(out_fname, output);
 }
 
@@ -284,15 +326,15 @@ LowpassFilterParser::LowpassFilterParser(){
     name = "lowpass";
 }
 
-Transform<MatrixXi, MatrixXi>* LowpassFilterParser::parse(const vector<string>& arguments) {
+Transform<MatrixXu8, MatrixXu8>* LowpassFilterParser::parse(const vector<string>& arguments) {
     cout << "n_args = " << arguments.size() << "\n";
 
     if (arguments.size() != 2 + arg_num)
         throw std::invalid_argument("Lowpass filter requires one argument (threshold).");
 
     // throws an exception if not convertible to int
-    int thr_high = std::stoi(arguments[2]);
-    return new HighpassFilter(thr_high);
+    int thr_low = std::stoi(arguments[2]);
+    return new LowpassFilter<double, uint8_t>(thr_low);
 }
 
 void LowpassFilterParser::apply(const vector <string>& arguments) {
@@ -302,8 +344,178 @@ void LowpassFilterParser::apply(const vector <string>& arguments) {
     string inp_fname = glob_path + arguments[0];
     string out_fname = glob_path + arguments[1];
 
-    MatrixXi input = readIntMatrix(inp_fname);
-    auto thresh = parse(arguments);
-    MatrixXi output = thresh->transform(input);
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    std::unique_ptr<Transform<MatrixXu8, MatrixXu8>> thresh(parse(arguments));
+    MatrixXu8 output = thresh->transform(input);
     writeIntMatrix(out_fname, output);
-}
\ No newline at end of file
+}
+
+
+// FrequencyFilterParser
+
+FrequencyFilterParser::FrequencyFilterParser(FilterSpec::Type type_){
+    type = type_;
+    switch (type) {
+        case FilterSpec::GaussianLowpass:
+            name = "gaussianlow";
+            arg_num = 1;
+            break;
+        case FilterSpec::GaussianHighpass:
+            name = "gaussianhigh";
+            arg_num = 1;
+            break;
+        case FilterSpec::ButterworthLowpass:
+            name = "butterworthlow";
+            arg_num = 2;
+            break;
+        case FilterSpec::ButterworthHighpass:
+            name = "butterworthhigh";
+            arg_num = 2;
+            break;
+        case FilterSpec::Bandpass:
+            name = "bandpass";
+            arg_num = 3;
+            break;
+        case FilterSpec::Notch:
+            name = "notch";
+            arg_num = 4;
+            break;
+        default:
+            throw std::invalid_argument("Ideal filters are parsed by the lowpass and highpass parsers.");
+    }
+}
+
+Transform<MatrixXu8, MatrixXu8>* FrequencyFilterParser::parse(const vector<string>& arguments) {
+    checkArgNum(arguments);
+
+    // throws an exception if not convertible to double/int
+    FilterSpec spec{type, std::stod(arguments[2])};
+    if (type == FilterSpec::ButterworthLowpass || type == FilterSpec::ButterworthHighpass) {
+        spec.order = std::stoi(arguments[3]);
+    } else if (type == FilterSpec::Bandpass) {
+        spec.cutoff2 = std::stod(arguments[3]);
+        spec.order = std::stoi(arguments[4]);
+    } else if (type == FilterSpec::Notch) {
+        spec.notchRow = std::stoi(arguments[3]);
+        spec.notchCol = std::stoi(arguments[4]);
+        spec.order = std::stoi(arguments[5]);
+    }
+    return new FrequencyFilter<double, uint8_t>(spec);
+}
+
+void FrequencyFilterParser::apply(const vector <string>& arguments) {
+    checkArgNum(arguments);
+
+    string glob_path = std::experimental::filesystem::current_path();
+    string inp_fname = glob_path + arguments[0];
+    string out_fname = glob_path + arguments[1];
+
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    std::unique_ptr<Transform<MatrixXu8, MatrixXu8>> filter(parse(arguments));
+    MatrixXu8 output = filter->transform(input);
+    writeIntMatrix(out_fname, output);
+}
+
+
+// LUTParser
+
+LUTParser::LUTParser(Type type_){
+    type = type_;
+    switch (type) {
+        case Gamma:
+            name = "gamma";
+            arg_num = 1;
+            break;
+        case Stretch:
+            name = "stretch";
+            arg_num = 2;
+            break;
+        default:
+            name = "equalize";
+            arg_num = 0;
+    }
+}
+
+Transform<MatrixXu8, MatrixXu8>* LUTParser::parse(const vector<string>& arguments) {
+    checkArgNum(arguments);
+
+    // throws an exception if not convertible to double/int
+    if (type == Gamma) {
+        return new GammaCorrection(std::stod(arguments[2]));
+    } else if (type == Stretch) {
+        return new ContrastStretch(std::stoi(arguments[2]), std::stoi(arguments[3]));
+    }
+    return new HistogramEqualization();
+}
+
+void LUTParser::apply(const vector <string>& arguments) {
+    checkArgNum(arguments);
+
+    string glob_path = std::experimental::filesystem::current_path();
+    string inp_fname = glob_path + arguments[0];
+    string out_fname = glob_path + arguments[1];
+
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    std::unique_ptr<Transform<MatrixXu8, MatrixXu8>> lut(parse(arguments));
+    MatrixXu8 output = lut->transform(input);
+    writeIntMatrix(out_fname, output);
+}
+
+
+// ChainParser
+
+ChainParser::ChainParser() {
+    arg_num = 1;
+    name = "chain";
+}
+
+LUTTransform* ChainParser::parse(const vector<string>& arguments) {
+    if (arguments.size() < 2 + size_t(arg_num)) {
+        throw std::invalid_argument("Chain requires at least one step.");
+    }
+
+    /*every step is composed with the table of the previous ones*/
+    LUTTransform fused;
+    size_t i = 2;
+    while (i < arguments.size()) {
+        const string &step = arguments[i];
+        size_t step_args;
+        if (step == "gamma") {
+            step_args = 1;
+        } else if (step == "threshold" || step == "clamp" || step == "stretch" || step == "scale") {
+            step_args = 2;
+        } else {
+            throw std::invalid_argument("Unknown step of the chain: " + step +
+                                        " (pointwise steps: threshold, clamp, gamma, stretch, scale).");
+        }
+        if (i + step_args >= arguments.size()) {
+            throw std::invalid_argument("Missing parameters for the step " + step + " of the chain.");
+        }
+
+        // throws an exception if not convertible to double/int
+        if (step == "threshold" || step == "clamp") {
+            fused = fused.then(Thresholding<uint8_t>(std::stoi(arguments[i + 1]), std::stoi(arguments[i + 2])).toLUT());
+        } else if (step == "gamma") {
+            fused = fused.then(GammaCorrection(std::stod(arguments[i + 1])));
+        } else if (step == "stretch") {
+            fused = fused.then(ContrastStretch(std::stoi(arguments[i + 1]), std::stoi(arguments[i + 2])));
+        } else {
+            double factor = std::stod(arguments[i + 1]);
+            double offset = std::stod(arguments[i + 2]);
+            fused = fused.then(LUTTransform::fromFunction([factor, offset](int v) { return factor * v + offset; }));
+        }
+        i += 1 + step_args;
+    }
+    return new LUTTransform(fused);
+}
+
+void ChainParser::apply(const vector <string>& arguments) {
+    std::unique_ptr<LUTTransform> chain(parse(arguments));
+
+    string glob_path = std::experimental::filesystem::current_path();
+    string inp_fname = glob_path + arguments[0];
+    string out_fname = glob_path + arguments[1];
+    MatrixXu8 input = readIntMatrix<uint8_t>(inp_fname);
+    chain->transformInPlace(input);
+    writeIntMatrix(out_fname, input);
+}
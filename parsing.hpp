@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdlib>
 #include "Eigen/Dense"
 #include "utils.hpp"
 #include "transforms.hpp"
@@ -96,7 +97,7 @@ public:
  * @brief Parser for the Thresholding transformation.
  * @see transforms::Thresholding
  */
-class ThresholdingParser: public Parser<MatrixXi, MatrixXi> {
+class ThresholdingParser: public Parser<MatrixXu8, MatrixXu8> {
 public:
     /**
      * @brief Construct a new Thresholding Parser object
@@ -108,9 +109,9 @@ public:
      * @brief Instantiate a threshold transform.
      * 
      * @param arguments List of arguments (parameters of the transform) passed through the command line.
-     * @return Transform<MatrixXi, MatrixXi>* Instance of the Thresholding transform.
+     * @return Transform<MatrixXu8, MatrixXu8>* Instance of the Thresholding transform.
      */
-    Transform<MatrixXi, MatrixXi>* parse(const vector<string>& arguments) override;
+    Transform<MatrixXu8, MatrixXu8>* parse(const vector<string>& arguments) override;
 
     /**
      * @brief Apply the Thresholding transform (read the input file, create and use the transform, save the output file).
@@ -125,7 +126,7 @@ public:
  * @brief Parser for the histogram calculation.
  * @see transforms::Histogram
  */
-class HistogramParser: public Parser<MatrixXi, MatrixXd> {
+class HistogramParser: public Parser<MatrixXu8, MatrixXd> {
 public:
     /**
      * @brief Construct a new Histogram Parser object
@@ -137,9 +138,9 @@ public:
      * @brief Instantiate a histogram calculation.
      *
      * @param arguments List of arguments (parameters of the transform) passed through the command line.
-     * @return Transform<MatrixXi, MatrixXd>* Instance of the Histogram transform.
+     * @return Transform<MatrixXu8, MatrixXd>* Instance of the Histogram transform.
      */
-    Transform<MatrixXi, MatrixXd>* parse(const vector<string>& arguments) override;
+    Transform<MatrixXu8, MatrixXd>* parse(const vector<string>& arguments) override;
 
     /**
     * @brief Apply the Histogram transform (read the input file, create and use the transform, save the output file).
@@ -196,9 +197,9 @@ public:
      * @brief Instantiate a FFT2D transform.
      *
      * @param arguments List of arguments (parameters of the transform) passed through the command line.
-     * @return FFT2D* Instance of the FFT2D transform for magnitude.
+     * @return FFT2D<>* Instance of the FFT2D transform for magnitude.
      */
-    FFT2D* parse(const vector<string>& arguments) override;
+    FFT2D<>* parse(const vector<string>& arguments) override;
 
     /**
     * @brief Apply the FFT2D transform for magnitude (read the input file, create and use the transform to calculate magnitude,
@@ -244,7 +245,7 @@ public:
  * @brief Parser for the highpass filter transform.
  * @see transforms::HighpassFilter
  */
-class HighpassFilterParser: public Parser<MatrixXi, MatrixXi> {
+class HighpassFilterParser: public Parser<MatrixXu8, MatrixXu8> {
 public:
     /**
     * @brief Construct a new HighpassFilter Parser object
@@ -256,9 +257,9 @@ public:
      * @brief Instantiate a highpass filter transform.
      *
      * @param arguments List of arguments (parameters of the transform) passed through the command line.
-     * @return Transform<MatrixXi, MatrixXi>* Instance of the highpass filter transform.
+     * @return Transform<MatrixXu8, MatrixXu8>* Instance of the highpass filter transform.
      */
-    Transform<MatrixXi, MatrixXi>* parse(const vector<string>& arguments) override;
+    Transform<MatrixXu8, MatrixXu8>* parse(const vector<string>& arguments) override;
 
     /**
     * @brief Apply the highpass filter transform (read the input file, create and use the transform,
@@ -274,7 +275,7 @@ public:
  * @brief Parser for the lowpass filter transform.
  * @see transforms::LowpassFilter
  */
-class LowpassFilterParser: public Parser<MatrixXi, MatrixXi> {
+class LowpassFilterParser: public Parser<MatrixXu8, MatrixXu8> {
 public:
     /**
     * @brief Construct a new LowpassFilter Parser object
@@ -286,9 +287,9 @@ public:
      * @brief Instantiate a lowpass filter transform.
      *
      * @param arguments List of arguments (parameters of the transform) passed through the command line.
-     * @return Transform<MatrixXi, MatrixXi>* Instance of the lowpass filter transform.
+     * @return Transform<MatrixXu8, MatrixXu8>* Instance of the lowpass filter transform.
      */
-    Transform<MatrixXi, MatrixXi>* parse(const vector<string>& arguments) override;
+    Transform<MatrixXu8, MatrixXu8>* parse(const vector<string>& arguments) override;
 
     /**
     * @brief Apply the lowpass filter transform (read the input file, create and use the transform,
@@ -299,4 +300,111 @@ public:
     void apply(const vector <string>& arguments) override;
 };
 
-#endif
\ No newline at end of file
+/**
+ * @brief Parser for the smooth frequency filters (Gaussian, Butterworth, band-pass and notch).
+ * The arguments depend on the shape: cutoff (Gaussian), cutoff and order (Butterworth),
+ * lower and upper cutoffs and order (band-pass), radius, row and column offsets and order (notch).
+ * @see transforms::FrequencyFilter
+ */
+class FrequencyFilterParser: public Parser<MatrixXu8, MatrixXu8> {
+private:
+    FilterSpec::Type type; /// shape of the filter
+
+public:
+    /**
+    * @brief Construct a new FrequencyFilter Parser object
+    *
+    * @param type_ Shape of the filter (not an ideal filter, they have their own parsers)
+    */
+    explicit FrequencyFilterParser(FilterSpec::Type type_);
+
+    /**
+     * @brief Instantiate a frequency filter transform.
+     *
+     * @param arguments List of arguments (parameters of the transform) passed through the command line.
+     * @return Transform<MatrixXu8, MatrixXu8>* Instance of the frequency filter transform.
+     */
+    Transform<MatrixXu8, MatrixXu8>* parse(const vector<string>& arguments) override;
+
+    /**
+    * @brief Apply the frequency filter transform (read the input file, create and use the transform,
+    * save the output file).
+    *
+    * @param arguments List of arguments (parameters of the transform) passed through the command line.
+    */
+    void apply(const vector <string>& arguments) override;
+};
+
+
+/**
+ * @brief Parser for the lookup table transforms: gamma correction (gamma), linear contrast stretch (lower and upper
+ * pixel values) and histogram equalization (no argument).
+ * @see transforms::GammaCorrection, transforms::ContrastStretch, transforms::HistogramEqualization
+ */
+class LUTParser: public Parser<MatrixXu8, MatrixXu8> {
+public:
+    /**
+     * @brief Pointwise transforms of the parser.
+     */
+    enum Type {Gamma, Stretch, Equalize};
+
+private:
+    Type type; /// transform to parse
+
+public:
+    /**
+    * @brief Construct a new LUT Parser object
+    *
+    * @param type_ Transform to parse
+    */
+    explicit LUTParser(Type type_);
+
+    /**
+     * @brief Instantiate a lookup table transform.
+     *
+     * @param arguments List of arguments (parameters of the transform) passed through the command line.
+     * @return Transform<MatrixXu8, MatrixXu8>* Instance of the transform.
+     */
+    Transform<MatrixXu8, MatrixXu8>* parse(const vector<string>& arguments) override;
+
+    /**
+    * @brief Apply the lookup table transform (read the input file, create and use the transform, save the output file).
+    *
+    * @param arguments List of arguments (parameters of the transform) passed through the command line.
+    */
+    void apply(const vector <string>& arguments) override;
+};
+
+
+/**
+ * @brief Parser for a chain of pointwise transforms of 8-bit pixels, fused into a single lookup table so that the
+ * image is read and written once. The arguments are the steps with their parameters, applied in order:
+ * "threshold min max" (or "clamp min max"), "gamma gamma", "stretch low high" and "scale factor offset"
+ * (factor * pixel + offset, saturated).
+ * @see transforms::LUTTransform
+ */
+class ChainParser: public Parser<MatrixXu8, MatrixXu8> {
+public:
+    /**
+    * @brief Construct a new Chain Parser object
+    *
+    */
+    ChainParser();
+
+    /**
+     * @brief Instantiate the fused transform of the chain.
+     *
+     * @param arguments List of arguments (steps of the chain and their parameters) passed through the command line.
+     * @return LUTTransform* Instance of the fused transform.
+     */
+    LUTTransform* parse(const vector<string>& arguments) override;
+
+    /**
+    * @brief Apply the chain (read the input file, create and use the fused transform, save the output file).
+    *
+    * @param arguments List of arguments (steps of the chain and their parameters) passed through the command line.
+    */
+    void apply(const vector <string>& arguments) override;
+};
+
+#endif
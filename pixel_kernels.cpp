@@ -0,0 +1,277 @@
+#include "transforms.hpp"
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+// Clamp of contiguous pixels
+//
+// out[k] = min(max(in[k], lo), hi) for k < n, in may be equal to out (in-place thresholding).
+// The vector kernels clamp one vector of pixels per iteration with the min/max instructions of the
+// pixel type and leave the n % lanes last pixels to the scalar loop.
+
+template <typename P>
+static void clampScalar(const P in[], P out[], size_t n, P lo, P hi) {
+    for (size_t k = 0; k < n; k++) {
+        out[k] = std::min(std::max(in[k], lo), hi);
+    }
+}
+
+#ifdef PIXEL_X86_KERNELS
+
+__attribute__((target("sse4.1")))
+static void clampSSE41U8(const uint8_t in[], uint8_t out[], size_t n, uint8_t lo, uint8_t hi) {
+    const __m128i vlo = _mm_set1_epi8(char(lo)), vhi = _mm_set1_epi8(char(hi));
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + k));
+        _mm_storeu_si128((__m128i *)(out + k), _mm_min_epu8(_mm_max_epu8(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("sse4.1")))
+static void clampSSE41U16(const uint16_t in[], uint16_t out[], size_t n, uint16_t lo, uint16_t hi) {
+    const __m128i vlo = _mm_set1_epi16(short(lo)), vhi = _mm_set1_epi16(short(hi));
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + k));
+        _mm_storeu_si128((__m128i *)(out + k), _mm_min_epu16(_mm_max_epu16(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("sse4.1")))
+static void clampSSE41I32(const int in[], int out[], size_t n, int lo, int hi) {
+    const __m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + k));
+        _mm_storeu_si128((__m128i *)(out + k), _mm_min_epi32(_mm_max_epi32(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("avx2")))
+static void clampAVX2U8(const uint8_t in[], uint8_t out[], size_t n, uint8_t lo, uint8_t hi) {
+    const __m256i vlo = _mm256_set1_epi8(char(lo)), vhi = _mm256_set1_epi8(char(hi));
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + k));
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_min_epu8(_mm256_max_epu8(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("avx2")))
+static void clampAVX2U16(const uint16_t in[], uint16_t out[], size_t n, uint16_t lo, uint16_t hi) {
+    const __m256i vlo = _mm256_set1_epi16(short(lo)), vhi = _mm256_set1_epi16(short(hi));
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + k));
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_min_epu16(_mm256_max_epu16(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("avx2")))
+static void clampAVX2I32(const int in[], int out[], size_t n, int lo, int hi) {
+    const __m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + k));
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_min_epi32(_mm256_max_epi32(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void clampAVX512U8(const uint8_t in[], uint8_t out[], size_t n, uint8_t lo, uint8_t hi) {
+    const __m512i vlo = _mm512_set1_epi8(char(lo)), vhi = _mm512_set1_epi8(char(hi));
+    size_t k = 0;
+    for (; k + 64 <= n; k += 64) {
+        __m512i x = _mm512_loadu_si512((const void *)(in + k));
+        _mm512_storeu_si512((void *)(out + k), _mm512_min_epu8(_mm512_max_epu8(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void clampAVX512U16(const uint16_t in[], uint16_t out[], size_t n, uint16_t lo, uint16_t hi) {
+    const __m512i vlo = _mm512_set1_epi16(short(lo)), vhi = _mm512_set1_epi16(short(hi));
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m512i x = _mm512_loadu_si512((const void *)(in + k));
+        _mm512_storeu_si512((void *)(out + k), _mm512_min_epu16(_mm512_max_epu16(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void clampAVX512I32(const int in[], int out[], size_t n, int lo, int hi) {
+    const __m512i vlo = _mm512_set1_epi32(lo), vhi = _mm512_set1_epi32(hi);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512i x = _mm512_loadu_si512((const void *)(in + k));
+        _mm512_storeu_si512((void *)(out + k), _mm512_min_epi32(_mm512_max_epi32(x, vlo), vhi));
+    }
+    clampScalar(in + k, out + k, n - k, lo, hi);
+}
+
+#endif
+
+
+// Table lookup of 8-bit pixels
+//
+// out[k] = table[in[k]] for k < n with a 256-entry table, in may be equal to out.
+// The SSE4.1 and AVX2 kernels split the table into 16 rows of 16 entries and look up every row with a byte
+// shuffle: t = in[k] - 16 r is in [0, 15] for the pixels of row r only, adding 0x70 with unsigned saturation
+// keeps the low nibble of these pixels and sets the high bit of the others, which the shuffle turns into 0.
+// The AVX-512 VBMI kernel looks up 128 entries with a single two-table byte permutation.
+
+static void lookupScalar(const uint8_t in[], uint8_t out[], size_t n, const uint8_t table[]) {
+    for (size_t k = 0; k < n; k++) {
+        out[k] = table[in[k]];
+    }
+}
+
+#ifdef PIXEL_X86_KERNELS
+
+__attribute__((target("sse4.1")))
+static void lookupSSE41(const uint8_t in[], uint8_t out[], size_t n, const uint8_t table[]) {
+    __m128i rows[16];
+    for (int r = 0; r < 16; r++) {
+        rows[r] = _mm_loadu_si128((const __m128i *)(table + 16 * r));
+    }
+    const __m128i step = _mm_set1_epi8(16), select = _mm_set1_epi8(0x70);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m128i t = _mm_loadu_si128((const __m128i *)(in + k));
+        __m128i y = _mm_setzero_si128();
+        for (int r = 0; r < 16; r++) {
+            y = _mm_or_si128(y, _mm_shuffle_epi8(rows[r], _mm_adds_epu8(t, select)));
+            t = _mm_sub_epi8(t, step);
+        }
+        _mm_storeu_si128((__m128i *)(out + k), y);
+    }
+    lookupScalar(in + k, out + k, n - k, table);
+}
+
+__attribute__((target("avx2")))
+static void lookupAVX2(const uint8_t in[], uint8_t out[], size_t n, const uint8_t table[]) {
+    __m256i rows[16];
+    for (int r = 0; r < 16; r++) {
+        rows[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(table + 16 * r)));
+    }
+    const __m256i step = _mm256_set1_epi8(16), select = _mm256_set1_epi8(0x70);
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m256i t = _mm256_loadu_si256((const __m256i *)(in + k));
+        __m256i y = _mm256_setzero_si256();
+        for (int r = 0; r < 16; r++) {
+            y = _mm256_or_si256(y, _mm256_shuffle_epi8(rows[r], _mm256_adds_epu8(t, select)));
+            t = _mm256_sub_epi8(t, step);
+        }
+        _mm256_storeu_si256((__m256i *)(out + k), y);
+    }
+    lookupScalar(in + k, out + k, n - k, table);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void lookupAVX512VBMI(const uint8_t in[], uint8_t out[], size_t n, const uint8_t table[]) {
+    const __m512i t0 = _mm512_loadu_si512((const void *)table), t1 = _mm512_loadu_si512((const void *)(table + 64));
+    const __m512i t2 = _mm512_loadu_si512((const void *)(table + 128));
+    const __m512i t3 = _mm512_loadu_si512((const void *)(table + 192));
+    size_t k = 0;
+    for (; k + 64 <= n; k += 64) {
+        __m512i x = _mm512_loadu_si512((const void *)(in + k));
+        /*the low 7 bits select the entry in each half of the table, the high bit selects the half*/
+        __m512i low = _mm512_permutex2var_epi8(t0, x, t1);
+        __m512i high = _mm512_permutex2var_epi8(t2, x, t3);
+        _mm512_storeu_si512((void *)(out + k), _mm512_mask_blend_epi8(_mm512_movepi8_mask(x), low, high));
+    }
+    lookupScalar(in + k, out + k, n - k, table);
+}
+
+#endif
+
+
+// Kernel table and runtime dispatch
+
+static bool alwaysSupported() {
+    return true;
+}
+
+#ifdef PIXEL_X86_KERNELS
+static bool sse41Supported() {
+    return __builtin_cpu_supports("sse4.1");
+}
+
+static bool avx2Supported() {
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool avx512Supported() {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+
+static bool avx512VBMISupported() {
+    return avx512Supported() && __builtin_cpu_supports("avx512vbmi");
+}
+#endif
+
+/*ordered from the widest to the narrowest, the scalar kernel is always last*/
+static const PixelKernel kernels[] = {
+#ifdef PIXEL_X86_KERNELS
+    {"avx512vbmi", avx512VBMISupported, clampAVX512U8, clampAVX512U16, clampAVX512I32, lookupAVX512VBMI},
+    {"avx512", avx512Supported, clampAVX512U8, clampAVX512U16, clampAVX512I32, lookupAVX2},
+    {"avx2", avx2Supported, clampAVX2U8, clampAVX2U16, clampAVX2I32, lookupAVX2},
+    {"sse4.1", sse41Supported, clampSSE41U8, clampSSE41U16, clampSSE41I32, lookupSSE41},
+#endif
+    {"scalar", alwaysSupported, clampScalar<uint8_t>, clampScalar<uint16_t>, clampScalar<int>, lookupScalar},
+};
+
+static const PixelKernel *detectKernel() {
+    for (const auto &kernel : kernels) {
+        if (kernel.supported()) {
+            return &kernel;
+        }
+    }
+    return &kernels[0];
+}
+
+static std::atomic<const PixelKernel *> &activeKernel() {
+    static std::atomic<const PixelKernel *> kernel(detectKernel());
+    return kernel;
+}
+
+const PixelKernel &pixelKernel() {
+    return *activeKernel().load(std::memory_order_relaxed);
+}
+
+std::string pixelKernelName() {
+    return pixelKernel().name;
+}
+
+std::vector<std::string> availablePixelKernels() {
+    std::vector<std::string> names;
+    for (const auto &kernel : kernels) {
+        if (kernel.supported()) {
+            names.emplace_back(kernel.name);
+        }
+    }
+    return names;
+}
+
+void setPixelKernel(const std::string &name) {
+    for (const auto &kernel : kernels) {
+        if (name == kernel.name && kernel.supported()) {
+            activeKernel().store(&kernel);
+            return;
+        }
+    }
+    throw std::invalid_argument("Pixel kernel " + name + " is not available on this CPU");
+}
@@ -2,6 +2,7 @@
 #include "utils.hpp"
 #include "transforms.hpp"
 #include "parsing.hpp"
+#include <thread>
 
 using Eigen::MatrixXi;
 using Eigen::MatrixXd;
@@ -49,6 +50,50 @@ TEST(UtilsTest, EIGEN2OPENCV) {
     EXPECT_EQ(test_max, 4);
 }
 
+/**
+ * @brief Check the zero-copy views of opencv images (padded rows) and the saturation of eigen2opencv.
+ * 
+ */
+TEST(UtilsTest, OPENCVVIEW) {
+    cv::Mat image(70, 131, CV_8U);
+    for (int i = 0; i < 70; i++) {
+        for (int j = 0; j < 131; j++) {
+            image.at<uchar>(i, j) = (i * 7 + j * 3) % 256;
+        }
+    }
+    // A region of interest has padded rows
+    const cv::Mat roi = image(cv::Rect(5, 3, 100, 66));
+    ConstImageView<> view = opencvView(roi);
+    EXPECT_EQ(view.data(), roi.data);
+    EXPECT_EQ(view(2, 7), image.at<uchar>(5, 12));
+    MatrixXi mat = opencv2eigen(roi);
+    ASSERT_EQ(mat.rows(), 66);
+    ASSERT_EQ(mat.cols(), 100);
+    EXPECT_EQ(mat, view.cast<int>().eval());
+    EXPECT_EQ(mat.maxCoeff(), 255);
+    EXPECT_THROW(opencvView(cv::Mat(2, 2, CV_32F)), std::invalid_argument);
+
+    // Values out of [0, 255] are saturated, the buffer of the image is reused
+    cv::Mat output;
+    eigen2opencv(mat, output);
+    EXPECT_EQ(cv::norm(output, roi, cv::NORM_INF), 0);
+    const uchar* buffer = output.data;
+    mat(0, 0) = -20;
+    mat(1, 0) = 300;
+    eigen2opencv(mat, output);
+    EXPECT_EQ(output.data, buffer);
+    EXPECT_EQ(output.at<uchar>(0, 0), 0);
+    EXPECT_EQ(output.at<uchar>(1, 0), 255);
+
+    // 16-bit images are converted without narrowing, and saturated to 8-bit pixels
+    cv::Mat deep(3, 4, CV_16U, cv::Scalar(1000));
+    MatrixXu16 deepMat = opencv2eigen<uint16_t>(deep);
+    EXPECT_EQ(deepMat.maxCoeff(), 1000);
+    EXPECT_EQ(opencv2eigen<uint8_t>(deep).minCoeff(), 255);
+    EXPECT_EQ(eigen2opencv(deepMat).type(), CV_16U);
+    EXPECT_EQ(cv::norm(eigen2opencv(deepMat), deep, cv::NORM_INF), 0);
+}
+
 
 // ==================================================================================
 // test transforms
@@ -89,6 +134,149 @@ TEST_F(TransformTest, THRESHOLDING){
     EXPECT_EQ(result(1, 1), 21);
 }
 
+/**
+ * @brief Check that every vectorized clamp kernel supported by the CPU thresholds like the scalar comparisons,
+ * in place, and with large frames split over the threads
+ * 
+ */
+TEST_F(TransformTest, THRESHOLDKERNELS){
+    EXPECT_THROW(setPixelKernel("unknown"), std::invalid_argument);
+    std::string detected = pixelKernelName();
+    EXPECT_EQ(detected, availablePixelKernels().front());
+
+    /// Odd sizes leave a tail to the scalar loop of the kernels
+    MatrixXi small(37, 29), large(1031, 517);
+    for (MatrixXi *item : {&small, &large}){
+        for (int i = 0; i < item->rows(); i++){
+            for (int j = 0; j < item->cols(); j++){
+                (*item)(i, j) = (i * 31 + j * 17) % 300 - 20;
+            }
+        }
+    }
+
+    ThreadPool::setGlobalThreads(3);
+    for (const auto &name : availablePixelKernels()){
+        setPixelKernel(name);
+        for (MatrixXi *item : {&small, &large}){
+            MatrixXi expected = item->cwiseMax(12).cwiseMin(200);
+            EXPECT_EQ(Thresholding(12, 200).transform(*item), expected) << name;
+
+            MatrixXu8 item8 = item->cwiseMax(0).cwiseMin(255).cast<uint8_t>();
+            MatrixXu8 expected8 = item8.cwiseMax(uint8_t(12)).cwiseMin(uint8_t(200));
+            EXPECT_EQ(Thresholding<uint8_t>(12, 200).transform(item8), expected8) << name;
+
+            MatrixXu16 item16 = (*item * 200).cwiseMax(0).cast<uint16_t>();
+            MatrixXu16 expected16 = item16.cwiseMax(uint16_t(1000)).cwiseMin(uint16_t(40000));
+            const uint16_t *data = item16.data();
+            Thresholding<uint16_t>(1000, 40000).transformInPlace(item16);
+            EXPECT_EQ(item16, expected16) << name;
+            EXPECT_EQ(item16.data(), data);
+        }
+    }
+    setPixelKernel(detected);
+    ThreadPool::setGlobalThreads(0);
+}
+
+/**
+ * @brief Check that every vectorized lookup kernel supported by the CPU applies a table like the scalar lookup, in place and
+ * on several threads, and the tables of the thresholding, gamma correction, contrast stretch and histogram equalization
+ * 
+ */
+TEST_F(TransformTest, LUTTRANSFORM){
+    std::array<uint8_t, 256> table;
+    for (int v = 0; v < 256; v++){
+        table[v] = uint8_t((v * 167 + 13) % 256);
+    }
+    LUTTransform lut(table);
+    MatrixXu8 small(37, 29), large(1031, 1031);
+    for (MatrixXu8 *item : {&small, &large}){
+        for (int k = 0; k < item->size(); k++){
+            (*item)(k) = uint8_t((k * 31 + k / 7) % 256);
+        }
+    }
+
+    std::string detected = pixelKernelName();
+    ThreadPool::setGlobalThreads(3);
+    for (const auto &name : availablePixelKernels()){
+        setPixelKernel(name);
+        for (MatrixXu8 *item : {&small, &large}){
+            MatrixXu8 expected = item->unaryExpr([&](uint8_t v) { return table[v]; });
+            EXPECT_EQ(lut.transform(*item), expected) << name;
+            MatrixXu8 inPlace = *item;
+            lut.transformInPlace(inPlace);
+            EXPECT_EQ(inPlace, expected) << name;
+        }
+    }
+    setPixelKernel(detected);
+    ThreadPool::setGlobalThreads(0);
+
+    /// Tables of the transforms
+    Thresholding<uint8_t> threshold(30, 200);
+    EXPECT_EQ(threshold.toLUT().transform(large), threshold.transform(large));
+    EXPECT_THROW(GammaCorrection(0), std::invalid_argument);
+    EXPECT_EQ(GammaCorrection(1).getTable(), LUTTransform().getTable());
+    EXPECT_EQ(GammaCorrection(0.5).getTable()[64], 128);
+    EXPECT_THROW(ContrastStretch(5, 5), std::invalid_argument);
+    ContrastStretch stretch(50, 100);
+    EXPECT_EQ(stretch.getTable()[20], 0);
+    EXPECT_EQ(stretch.getTable()[50], 0);
+    EXPECT_EQ(stretch.getTable()[60], 51);
+    EXPECT_EQ(stretch.getTable()[100], 255);
+    EXPECT_EQ(stretch.getTable()[200], 255);
+
+    /// Equalization of a quarter of 10, a quarter of 20 and a half of 30, with the table of the image or of its histogram
+    MatrixXu8 image(4, 2);
+    image << 10, 30, 20, 30, 10, 30, 20, 30;
+    MatrixXu8 equalized(4, 2);
+    equalized << 0, 255, 85, 255, 0, 255, 85, 255;
+    EXPECT_EQ(HistogramEqualization().transform(image), equalized);
+    LUTTransform equalization = HistogramEqualization::table(Histogram<uint8_t>().transform(image), 10);
+    EXPECT_EQ(equalization.transform(image), equalized);
+    EXPECT_THROW(HistogramEqualization::table(MatrixXd::Ones(1, 10), 250), std::invalid_argument);
+    MatrixXu8 constant = MatrixXu8::Constant(3, 3, 42);
+    EXPECT_EQ(HistogramEqualization().transform(constant), constant);
+}
+
+/**
+ * @brief Check that fused chains of pointwise transforms (composed tables and composed thresholds) give the same images
+ * as the transforms applied one after the other
+ * 
+ */
+TEST_F(TransformTest, FUSEDCHAIN){
+    MatrixXu8 image(61, 47);
+    for (int k = 0; k < image.size(); k++){
+        image(k) = uint8_t((k * 97 + k / 5) % 256);
+    }
+    Thresholding<uint8_t> threshold(20, 220);
+    GammaCorrection gamma(0.6);
+    ContrastStretch stretch(40, 200);
+    LUTTransform scale = LUTTransform::fromFunction([](int v) { return 0.8 * v + 10; });
+    MatrixXu8 expected = scale.transform(stretch.transform(gamma.transform(threshold.transform(image))));
+    LUTTransform fused = threshold.toLUT().then(gamma).then(stretch).then(scale);
+    EXPECT_EQ(fused.transform(image), expected);
+    EXPECT_EQ(LUTTransform().then(gamma).getTable(), gamma.getTable());
+
+    /// the chain command fuses the same steps, with clamp as another name of threshold
+    std::unique_ptr<LUTTransform> parsed(ChainParser().parse(
+        {"in.png", "out.png", "clamp", "20", "220", "gamma", "0.6", "stretch", "40", "200", "scale", "0.8", "10"}));
+    EXPECT_EQ(parsed->transform(image), expected);
+    EXPECT_THROW(ChainParser().parse({"in.png", "out.png", "scale", "0.8"}), std::invalid_argument);
+    EXPECT_THROW(ChainParser().parse({"in.png", "out.png", "blur", "3"}), std::invalid_argument);
+
+    /// Thresholds with overlapping, nested and disjoint ranges
+    MatrixXi pixels(17, 13);
+    for (int k = 0; k < pixels.size(); k++){
+        pixels(k) = (k * 37) % 300 - 20;
+    }
+    std::vector<std::pair<int, int>> ranges = {{10, 100}, {50, 200}, {60, 70}, {150, 250}, {0, 5}};
+    for (const auto &first : ranges){
+        for (const auto &second : ranges){
+            Thresholding<> a(first.first, first.second), b(second.first, second.second);
+            EXPECT_EQ(a.then(b).transform(pixels), b.transform(a.transform(pixels)));
+        }
+    }
+}
+
 /**
  * @brief Check correctness of the histogram transform
  * 
@@ -106,15 +294,120 @@ TEST_F(TransformTest, HISTOGRAM){
     ASSERT_NEAR(mat(0,3), 0.5, 1e-5);
 }
 
+/**
+ * @brief Check the histogram counts against a direct count for int, 8-bit and 16-bit pixels, with narrow and wide
+ * ranges of values, small and large images, on one and several threads
+ * 
+ */
+TEST_F(TransformTest, HISTOGRAMCOUNTS){
+    EXPECT_THROW(Histogram<>().transform(MatrixXi(0, 0)), std::invalid_argument);
+
+    /// Histogram of the values of a sample, from its minimum to its maximum
+    auto reference = [](const MatrixXi &sample) {
+        int low = sample.minCoeff();
+        MatrixXd hist = MatrixXd::Zero(1, sample.maxCoeff() - low + 1);
+        for (int k = 0; k < sample.size(); k++){
+            hist(0, sample(k) - low) += 1;
+        }
+        return MatrixXd(hist / double(sample.size()));
+    };
+    auto check = [&](const MatrixXi &sample) {
+        MatrixXd expected = reference(sample);
+        EXPECT_TRUE(Histogram<>().transform(sample).isApprox(expected, 1e-12));
+        if (sample.minCoeff() >= 0 && sample.maxCoeff() <= 65535){
+            MatrixXu16 sample16 = sample.cast<uint16_t>();
+            EXPECT_TRUE(Histogram<uint16_t>().transform(sample16).isApprox(expected, 1e-12));
+        }
+        if (sample.minCoeff() >= 0 && sample.maxCoeff() <= 255){
+            MatrixXu8 sample8 = sample.cast<uint8_t>();
+            EXPECT_TRUE(Histogram<uint8_t>().transform(sample8).isApprox(expected, 1e-12));
+        }
+    };
+
+    for (int threads : {1, 3}){
+        ThreadPool::setGlobalThreads(threads);
+        for (int rows : {13, 1031}){
+            int cols = (rows == 13) ? 7 : 517;
+            MatrixXi narrow(rows, cols), wide(rows, cols), runs(rows, cols);
+            for (int i = 0; i < rows; i++){
+                for (int j = 0; j < cols; j++){
+                    narrow(i, j) = 40 + (i * 31 + j * 17) % 150;
+                    wide(i, j) = (i * 7919 + j * 104729) % 60000 - (i % 2) * 100;
+                    runs(i, j) = 100 + j % 3;
+                }
+            }
+            check(narrow);
+            check(wide);
+            check(wide.cwiseAbs());
+            check(runs);
+
+            /// ranges that drift along the image grow the count tables in both directions
+            MatrixXi ramp(rows, cols);
+            for (int k = 0; k < ramp.size(); k++){
+                ramp(k) = k - ramp.size() / 2 + (k % 5) * 300;
+            }
+            check(ramp);
+            check(MatrixXi(-ramp));
+            check(MatrixXi(ramp.cwiseAbs()));
+        }
+    }
+    ThreadPool::setGlobalThreads(0);
+}
+
+/**
+ * @brief Check the histogram with fixed bins for double, float and 16-bit values (compare with the bins of the values),
+ * with values out of the range, on one and several threads
+ * 
+ */
+TEST_F(TransformTest, BINNEDHISTOGRAM){
+    EXPECT_THROW(BinnedHistogram<>(0, 0., 1.), std::invalid_argument);
+    EXPECT_THROW(BinnedHistogram<>(10, 1., 1.), std::invalid_argument);
+    EXPECT_THROW(BinnedHistogram<>(10, 0., 1.).transform(MatrixXd(0, 0)), std::invalid_argument);
+
+    /// Samples in [-1, 1] away from the edges of 64 bins, with a known bin
+    int bins = 64;
+    double width = 2. / bins;
+    for (int threads : {1, 3}){
+        ThreadPool::setGlobalThreads(threads);
+        for (int rows : {11, 1201}){
+            MatrixXd samples(rows, 301);
+            MatrixXd expected = MatrixXd::Zero(1, bins);
+            for (int k = 0; k < samples.size(); k++){
+                int bin = int(std::abs(std::sin(0.01 * k)) * bins) % bins;
+                samples(k) = -1 + (bin + 0.25 + 0.5 * ((k * 37) % 101) / 100.) * width;
+                expected(0, bin) += 1. / samples.size();
+            }
+            EXPECT_TRUE(BinnedHistogram<>(bins, -1., 1.).transform(samples).isApprox(expected, 1e-12));
+            Eigen::MatrixXf samplesFloat = samples.cast<float>();
+            EXPECT_TRUE(BinnedHistogram<float>(bins, -1., 1.).transform(samplesFloat).isApprox(expected, 1e-12));
+        }
+    }
+    ThreadPool::setGlobalThreads(0);
+
+    /// 16-bit pixels in 256 bins of 256 values
+    MatrixXu16 pixels(97, 89);
+    MatrixXd expected = MatrixXd::Zero(1, 256);
+    for (int k = 0; k < pixels.size(); k++){
+        pixels(k) = (k * 7919) % 65536;
+        expected(0, pixels(k) / 256) += 1. / pixels.size();
+    }
+    EXPECT_TRUE(BinnedHistogram<uint16_t>(256, 0., 65536.).transform(pixels).isApprox(expected, 1e-12));
+
+    /// Values out of the range are counted in the first and the last bins
+    MatrixXd values(1, 6);
+    values << -5., 0., 0.5, 1., 7., std::nan("");
+    MatrixXd hist = BinnedHistogram<>(2, 0., 1.).transform(values);
+    EXPECT_EQ(hist.cols(), 2);
+    EXPECT_NEAR(hist(0, 0), 3. / 6, 1e-12);
+    EXPECT_NEAR(hist(0, 1), 3. / 6, 1e-12);
+}
+
 /**
  * @brief Check correctness of 1d Fourier transform
  * 
  */
 TEST_F(TransformTest, FFT1DTEST){
     FFT1D fft;
-    /// Check exception thrown
-    EXPECT_THROW(fft.getMagnitude(), std::logic_error);
-
     auto mat = fft.transform(item_1);
     EXPECT_EQ(mat(0), std::complex<double>(33, 0));
     EXPECT_EQ(mat(1), std::complex<double>(-5, 5));
@@ -139,15 +432,243 @@ TEST_F(TransformTest, FFT1DANDINVERSE){
     }
 }
 
+/**
+ * @brief Check FFT plans against the direct DFT (power of two, mixed radix and Bluestein sizes)
+ * 
+ */
+TEST_F(TransformTest, FFTPLAN){
+    EXPECT_THROW(FFTPlan<float>(0, -1), std::invalid_argument);
+    EXPECT_EQ(FFTPlan<float>(64, -1).strategy(), FFTPlan<float>::Radix2);
+    EXPECT_EQ(FFTPlan<float>(2 * 3 * 4 * 5 * 7, -1).strategy(), FFTPlan<float>::MixedRadix);
+    EXPECT_EQ(FFTPlan<float>(2 * 37, -1).strategy(), FFTPlan<float>::Bluestein);
+
+    for (int n : {32, 64, 60, 49, 75, 74, 101}) {
+        std::vector<std::complex<float>> signal(n);
+        std::vector<std::complex<double>> signalDouble(n);
+        for (int i = 0; i < n; i++){
+            signal[i] = std::complex<float>(i % 7, (3 * i) % 5);
+            signalDouble[i] = signal[i];
+        }
+        std::vector<std::complex<float>> result = signal;
+        FFTPlan<float>::get(n, -1)->execute(result.data());
+        std::vector<std::complex<double>> resultDouble = signalDouble;
+        FFTPlan<double>::get(n, -1)->execute(resultDouble.data());
+
+        for (int k = 0; k < n; k++){
+            std::complex<double> ref = 0;
+            for (int i = 0; i < n; i++){
+                ref += signalDouble[i] * std::polar(1.0, -2 * M_PI * i * k / n);
+            }
+            ASSERT_NEAR(result[k].real(), ref.real(), 1e-3 * n);
+            ASSERT_NEAR(result[k].imag(), ref.imag(), 1e-3 * n);
+            ASSERT_NEAR(resultDouble[k].real(), ref.real(), 1e-10 * n);
+            ASSERT_NEAR(resultDouble[k].imag(), ref.imag(), 1e-10 * n);
+        }
+    }
+
+    /// Check the cache returns the same plan
+    EXPECT_EQ(FFTPlan<float>::get(64, 1), FFTPlan<float>::get(64, 1));
+
+    /// a plan requested by several threads at once is built (and tuned) once
+    bool autotune = FFTWisdom::autotune();
+    FFTWisdom::setAutotune(true);
+    std::vector<std::shared_ptr<const FFTPlan<double>>> plans(8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++){
+        threads.emplace_back([&plans, t] { plans[t] = FFTPlan<double>::get(2 * 3 * 5 * 7 * 11, 1); });
+    }
+    for (auto &thread : threads){
+        thread.join();
+    }
+    FFTWisdom::setAutotune(autotune);
+    for (const auto &plan : plans){
+        EXPECT_EQ(plan, plans[0]);
+    }
+}
+
+/**
+ * @brief Check that every vectorized butterfly kernel supported by the CPU matches the scalar one
+ * 
+ */
+TEST_F(TransformTest, FFTKERNELS){
+    EXPECT_THROW(setFFTKernel("unknown"), std::invalid_argument);
+    std::string detected = fftKernelName();
+    EXPECT_EQ(detected, availableFFTKernels().front());
+
+    int n = 4096;
+    std::vector<std::complex<float>> signal(n);
+    for (int i = 0; i < n; i++){
+        signal[i] = std::complex<float>(i % 11, (5 * i) % 3);
+    }
+    std::vector<std::complex<double>> signalDouble(signal.begin(), signal.end());
+    setFFTKernel("scalar");
+    std::vector<std::complex<float>> reference = signal;
+    FFTPlan<float>::get(n, -1)->execute(reference.data());
+    std::vector<std::complex<double>> referenceDouble = signalDouble;
+    FFTPlan<double>::get(n, -1)->execute(referenceDouble.data());
+
+    for (const auto &name : availableFFTKernels()){
+        setFFTKernel(name);
+        std::vector<std::complex<float>> result = signal;
+        FFTPlan<float>::get(n, -1)->execute(result.data());
+        std::vector<std::complex<double>> resultDouble = signalDouble;
+        FFTPlan<double>::get(n, -1)->execute(resultDouble.data());
+        for (int k = 0; k < n; k++){
+            ASSERT_NEAR(std::abs(result[k] - reference[k]), 0, 1e-2) << name;
+            ASSERT_NEAR(std::abs(resultDouble[k] - referenceDouble[k]), 0, 1e-8) << name;
+        }
+    }
+    setFFTKernel(detected);
+}
+
+/**
+ * @brief Check that tuned plan choices are valid, and that the wisdom file restores them
+ * 
+ */
+TEST_F(TransformTest, FFTWISDOM){
+    FFTPlanChoice invalid;
+    invalid.strategy = FFTPlanChoice::MixedRadix;
+    invalid.radices = {4, 3};
+    EXPECT_FALSE(invalid.valid(60));
+    EXPECT_THROW(FFTPlan<float>(60, -1, invalid), std::invalid_argument);
+
+    FFTWisdom::clear();
+    for (int n : {64, 60, 74}) {
+        FFTPlanChoice tuned = FFTPlan<double>::measure(n, -1);
+        EXPECT_TRUE(tuned.valid(n));
+        FFTWisdom::record(n, -1, "double", tuned);
+
+        /// the tuned plan computes the same transform as the estimated one
+        std::vector<std::complex<double>> signal(n), reference(n);
+        for (int i = 0; i < n; i++){
+            signal[i] = reference[i] = std::complex<double>(i % 7, (3 * i) % 5);
+        }
+        FFTPlan<double>(n, -1, tuned).execute(signal.data());
+        FFTPlan<double>(n, -1).execute(reference.data());
+        for (int k = 0; k < n; k++){
+            ASSERT_NEAR(std::abs(signal[k] - reference[k]), 0, 1e-9);
+        }
+    }
+    EXPECT_TRUE(FFTWisdom::modified());
+
+    std::string path = testing::TempDir() + "fft_wisdom_test.txt";
+    FFTWisdom::save(path);
+    FFTPlanChoice saved;
+    ASSERT_TRUE(FFTWisdom::lookup(60, -1, "double", saved));
+    FFTWisdom::clear();
+
+    FFTPlanChoice loaded;
+    EXPECT_FALSE(FFTWisdom::lookup(60, -1, "double", loaded));
+    EXPECT_TRUE(FFTWisdom::load(path));
+    ASSERT_TRUE(FFTWisdom::lookup(60, -1, "double", loaded));
+    EXPECT_EQ(loaded, saved);
+    EXPECT_FALSE(FFTWisdom::lookup(60, -1, "float", loaded));
+    EXPECT_FALSE(FFTWisdom::modified());
+
+    /// entries of other CPUs are ignored, malformed files are rejected
+    std::ofstream other(path);
+    other << "othercpu double 60 -1 mixed - 4,3\n";
+    other.close();
+    FFTWisdom::clear();
+    EXPECT_TRUE(FFTWisdom::load(path));
+    EXPECT_FALSE(FFTWisdom::lookup(60, -1, "double", loaded));
+    std::ofstream malformed(path);
+    malformed << fftCPUFeatures() << " double 60 -1 mixed - 4,3\n";
+    malformed.close();
+    EXPECT_THROW(FFTWisdom::load(path), std::invalid_argument);
+    EXPECT_FALSE(FFTWisdom::load(path + ".missing"));
+    FFTWisdom::clear();
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Check that the batched 1d Fourier transforms match FFT1D on every row and column
+ * 
+ */
+TEST_F(TransformTest, BATCHFFT1D){
+    MatrixXi item(6, 12);
+    for (int i = 0; i < 6; i++){
+        for (int j = 0; j < 12; j++){
+            item(i, j) = (i * 29 + j * 11) % 256;
+        }
+    }
+
+    BatchFFT1D<> rowsFFT(FFTAxis::Rows);
+    BatchFFT1D<> colsFFT(FFTAxis::Columns);
+    auto rowsFreq = rowsFFT.transform(item);
+    auto colsFreq = colsFFT.transform(item);
+    for (int i = 0; i < 6; i++){
+        FFT1D<> fft;
+        MatrixXi row = item.row(i);
+        auto freq = fft.transform(row);
+        for (int j = 0; j < 12; j++){
+            ASSERT_NEAR(std::abs(rowsFreq(i, j) - freq(j)), 0, 1e-9);
+        }
+    }
+    for (int j = 0; j < 12; j++){
+        FFT1D<> fft;
+        MatrixXi col = item.col(j).transpose();
+        auto freq = fft.transform(col);
+        for (int i = 0; i < 6; i++){
+            ASSERT_NEAR(std::abs(colsFreq(i, j) - freq(i)), 0, 1e-9);
+        }
+    }
+
+    iBatchFFT1D<> rowsIFFT(FFTAxis::Rows);
+    iBatchFFT1D<> colsIFFT(FFTAxis::Columns);
+    EXPECT_EQ(rowsIFFT.transform(rowsFreq), item);
+    EXPECT_EQ(colsIFFT.transform(colsFreq), item);
+}
+
+/**
+ * @brief Check that every FFT backend gives the same transforms as the in-house one
+ * 
+ */
+TEST_F(TransformTest, FFTBACKENDS){
+    EXPECT_THROW(setFFTBackend("unknown"), std::invalid_argument);
+    EXPECT_EQ(availableFFTBackends().front(), "inhouse");
+    EXPECT_STREQ(fftBackend().name(), "inhouse");
+
+    MatrixXi item(9, 14);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 14; j++){
+            item(i, j) = (i * 37 + j * 23) % 256;
+        }
+    }
+    FFT2D<> fft;
+    FFT2D<float> halfFFT(1, true);
+    auto reference = fft.transform(item);
+    auto halfReference = halfFFT.transform(item);
+
+    for (const auto &name : availableFFTBackends()){
+        setFFTBackend(name);
+        FFT2D<> backendFFT;
+        FFT2D<float> backendHalfFFT(1, true);
+        auto freq = backendFFT.transform(item);
+        auto halfFreq = backendHalfFFT.transform(item);
+        for (int i = 0; i < 9; i++){
+            for (int j = 0; j < 14; j++){
+                ASSERT_NEAR(std::abs(freq(i, j) - reference(i, j)), 0, 1e-9) << name;
+            }
+            for (int j = 0; j < 8; j++){
+                ASSERT_NEAR(std::abs(halfFreq(i, j) - halfReference(i, j)), 0, 1e-3) << name;
+            }
+        }
+
+        iFFT2D<> ifft;
+        iFFT2D<float> halfIFFT(14);
+        EXPECT_EQ(ifft.transform(freq), item) << name;
+        EXPECT_EQ(halfIFFT.transform(halfFreq), item) << name;
+    }
+    setFFTBackend("inhouse");
+}
+
 /**
  * @brief Check correctness of 2d Fourier transform
  * 
  */
 TEST_F(TransformTest, FFT2DTEST){
     FFT2D fft;
-    /// Check exception thrown
-    EXPECT_THROW(fft.getMagnitude(), std::logic_error);
-
     auto mat = fft.transform(item_1);
 
     EXPECT_EQ(mat(0,0), std::complex<double>(33, 0));
@@ -175,6 +696,601 @@ TEST_F(TransformTest, FFT2DANDINVERSE){
     }
 }
 
+/**
+ * @brief Check FFT2D and iFFT2D on a size that is not a power of two
+ * 
+ */
+TEST_F(TransformTest, FFT2DARBITRARYSIZE){
+    MatrixXi item(3, 5);
+    item << 1, 2, 3, 4, 5,
+            9, 8, 7, 6, 5,
+            0, 1, 0, 1, 0;
+    FFT2D fft;
+    iFFT2D ifft;
+    auto freq = fft.transform(item);
+
+    /// frequency (1, 2) against the direct DFT, normalized by sqrt(size)
+    std::complex<double> ref = 0;
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 5; j++){
+            ref += double(item(i, j)) * std::polar(1.0, -2 * M_PI * (i * 1.0 / 3 + j * 2.0 / 5));
+        }
+    }
+    ref /= std::sqrt(15.);
+    ASSERT_NEAR(freq(1, 2).real(), ref.real(), 1e-4);
+    ASSERT_NEAR(freq(1, 2).imag(), ref.imag(), 1e-4);
+
+    auto res = ifft.transform(freq);
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 5; j++){
+            EXPECT_EQ(res(i, j), item(i, j));
+        }
+    }
+}
+
+/**
+ * @brief Check the half-spectrum (r2c/c2r) mode of FFT2D and iFFT2D
+ * 
+ */
+TEST_F(TransformTest, FFT2DHALFSPECTRUM){
+    EXPECT_THROW(FFT2D(2, true), std::invalid_argument);
+
+    FFT2D full;
+    FFT2D half(1, true);
+    auto freq = full.transform(item_2);
+    auto halfFreq = half.transform(item_2);
+
+    /// Check return size (rows x (cols/2+1)) and contents
+    EXPECT_EQ(halfFreq.rows(), 2);
+    EXPECT_EQ(halfFreq.cols(), 3);
+    for (int i = 0; i < 2; i++){
+        for (int j = 0; j < 3; j++){
+            ASSERT_NEAR(std::abs(halfFreq(i, j) - freq(i, j)), 0, 1e-5);
+        }
+    }
+
+    iFFT2D wrongSize(6);
+    EXPECT_THROW(wrongSize.transform(halfFreq), std::invalid_argument);
+    iFFT2D ifft(4);
+    auto res = ifft.transform(halfFreq);
+    for (int i = 0; i < 2; i++){
+        for (int j = 0; j < 4; j++){
+            EXPECT_EQ(res(i, j), item_2(i, j));
+        }
+    }
+}
+
+/**
+ * @brief Check that the parallel loops cover their range and that FFT2D gives the same result on several threads
+ * 
+ */
+TEST_F(TransformTest, PARALLELFFT2D){
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+    std::vector<int> visits(103, 0);
+    pool.parallelFor(0, 103, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++){
+            visits[i]++;
+        }
+    });
+    EXPECT_EQ(std::count(visits.begin(), visits.end(), 1), 103);
+    EXPECT_THROW(pool.parallelFor(0, 8, [](int, int, int) { throw std::runtime_error("error"); }), std::runtime_error);
+
+    MatrixXi item(37, 64);
+    for (int i = 0; i < 37; i++){
+        for (int j = 0; j < 64; j++){
+            item(i, j) = (i * 13 + j * 7) % 256;
+        }
+    }
+    FFT2D fft;
+    ThreadPool::setGlobalThreads(1);
+    auto serial = fft.transform(item);
+    ThreadPool::setGlobalThreads(4);
+    auto parallel = fft.transform(item);
+    ThreadPool::setGlobalThreads(0);
+    EXPECT_EQ(serial, parallel);
+}
+
+/**
+ * @brief Check that the single precision transforms keep float spectra and match the double precision ones
+ * 
+ */
+TEST_F(TransformTest, FFTPRECISION){
+    MatrixXi item(24, 40);
+    for (int i = 0; i < 24; i++){
+        for (int j = 0; j < 40; j++){
+            item(i, j) = (i * 31 + j * 17) % 256;
+        }
+    }
+    FFT2D<float> fftFloat;
+    FFT2D<double> fftDouble;
+    ComplexMatrix<float> freqFloat = fftFloat.transform(item);
+    ComplexMatrix<double> freqDouble = fftDouble.transform(item);
+    EXPECT_EQ(sizeof(FFT2D<float>::getMagnitude(freqFloat)(0, 0)), sizeof(float));
+    for (int i = 0; i < 24; i++){
+        for (int j = 0; j < 40; j++){
+            ASSERT_NEAR(std::abs(std::complex<double>(freqFloat(i, j)) - freqDouble(i, j)), 0, 1e-2);
+        }
+    }
+
+    iFFT2D<float> ifftFloat;
+    EXPECT_EQ(ifftFloat.transform(freqFloat), item);
+    LowpassFilter<float> lowFloat(8);
+    LowpassFilter<double> lowDouble(8);
+    EXPECT_LE((lowFloat.transform(item) - lowDouble.transform(item)).cwiseAbs().maxCoeff(), 1);
+}
+
+/**
+ * @brief Check the cached frequency masks, and that the filters match masking the FFT2D spectrum by hand
+ * 
+ */
+TEST_F(TransformTest, FREQUENCYMASK){
+    FilterSpec low{FilterSpec::IdealLowpass, 3.5};
+    auto mask = FrequencyMask<double>::get(low, 9, 12, false);
+    EXPECT_EQ(mask, FrequencyMask<double>::get(low, 9, 12, false));
+    EXPECT_NE(mask, FrequencyMask<double>::get(low, 9, 12, true));
+    EXPECT_NE(mask, FrequencyMask<double>::get(FilterSpec{FilterSpec::IdealHighpass, 3.5}, 9, 12, false));
+    EXPECT_EQ(mask->rows(), 9);
+    EXPECT_EQ(mask->cols(), 12);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 12; j++){
+            double radius = std::sqrt((i - 4) * (i - 4) + (j - 6) * (j - 6));
+            EXPECT_EQ((*mask)(i, j), radius <= 3.5 ? 1. : 0.);
+        }
+    }
+    auto halfMask = FrequencyMask<double>::get(low, 9, 12, true);
+    EXPECT_EQ(halfMask->cols(), 7);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 7; j++){
+            EXPECT_EQ((*halfMask)(i, j), 0.5 * ((*mask)(i, j) + (*mask)((9 - i) % 9, (12 - j) % 12)));
+        }
+    }
+
+    MatrixXi item(9, 12);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 12; j++){
+            item(i, j) = (i * 41 + j * 13) % 256;
+        }
+    }
+    FFT2D<> fft;
+    auto freq = fft.transform(item);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 12; j++){
+            freq(i, j) *= (*mask)(i, j);
+        }
+    }
+    iFFT2D<> ifft;
+    LowpassFilter<> filter(3.5);
+    EXPECT_LE((filter.transform(item) - ifft.transform(freq)).cwiseAbs().maxCoeff(), 1);
+}
+
+/**
+ * @brief Check that a filter bank gives the same images as the individual filters, on one or several threads
+ * 
+ */
+TEST_F(TransformTest, FILTERBANK){
+    MatrixXi item(20, 30);
+    for (int i = 0; i < 20; i++){
+        for (int j = 0; j < 30; j++){
+            item(i, j) = (i * 19 + j * 7) % 256;
+        }
+    }
+    std::vector<FilterSpec> specs;
+    for (double cutoff : {1., 3., 5., 8.}){
+        specs.push_back(FilterSpec{FilterSpec::IdealLowpass, cutoff});
+        specs.push_back(FilterSpec{FilterSpec::IdealHighpass, cutoff});
+    }
+
+    FilterBank<> bank(specs);
+    for (int threads : {1, 3, 16}){
+        ThreadPool::setGlobalThreads(threads);
+        auto images = bank.transform(item);
+        ASSERT_EQ(images.size(), specs.size());
+        for (size_t f = 0; f < specs.size(); f++){
+            if (specs[f].type == FilterSpec::IdealLowpass){
+                LowpassFilter<> filter(specs[f].cutoff);
+                EXPECT_EQ(images[f], filter.transform(item));
+            } else {
+                HighpassFilter<> filter(specs[f].cutoff);
+                EXPECT_EQ(images[f], filter.transform(item));
+            }
+        }
+    }
+    ThreadPool::setGlobalThreads(0);
+    EXPECT_TRUE(FilterBank<>({}).transform(item).empty());
+}
+
+/**
+ * @brief Check the weights of the smooth filters, their validation, and FrequencyFilter against the other filters
+ * 
+ */
+TEST_F(TransformTest, FREQUENCYFILTER){
+    FilterSpec gauss{FilterSpec::GaussianLowpass, 2.5};
+    FilterSpec butter{FilterSpec::ButterworthHighpass, 2.5, 0, 3};
+    FilterSpec band{FilterSpec::Bandpass, 1.5, 4, 2};
+    FilterSpec notch{FilterSpec::Notch, 1, 0, 2, 2, -3};
+    auto gaussMask = FrequencyMask<double>::get(gauss, 9, 12, false);
+    auto butterMask = FrequencyMask<double>::get(butter, 9, 12, false);
+    auto bandMask = FrequencyMask<double>::get(band, 9, 12, false);
+    auto notchMask = FrequencyMask<double>::get(notch, 9, 12, false);
+    EXPECT_NE(butterMask, FrequencyMask<double>::get(FilterSpec{FilterSpec::ButterworthHighpass, 2.5, 0, 2}, 9, 12, false));
+    /// distances are measured from DC at (0, 0), wrapping around the edges of the spectrum
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 12; j++){
+            int u = std::min(i, 9 - i), v = std::min(j, 12 - j);
+            double d2 = u * u + v * v;
+            EXPECT_NEAR((*gaussMask)(i, j), std::exp(-d2 / 12.5), 1e-12);
+            EXPECT_NEAR((*butterMask)(i, j), d2 == 0 ? 0. : 1. / (1. + std::pow(6.25 / d2, 3)), 1e-12);
+            EXPECT_GE((*bandMask)(i, j), 0.);
+            EXPECT_LE((*bandMask)(i, j), 1.);
+        }
+    }
+    EXPECT_EQ((*gaussMask)(0, 0), 1.);
+    EXPECT_EQ((*bandMask)(0, 0), 0.);
+    EXPECT_GT((*bandMask)(0, 3), 0.5);
+    EXPECT_LT((*bandMask)(4, 6), 0.5);
+    EXPECT_EQ((*notchMask)(2, 9), 0.);
+    EXPECT_EQ((*notchMask)(7, 3), 0.);
+    EXPECT_GT((*notchMask)(0, 0), 0.9);
+
+    EXPECT_THROW(FrequencyFilter<>(FilterSpec{FilterSpec::GaussianLowpass, 0}), std::invalid_argument);
+    EXPECT_THROW(FrequencyFilter<>(FilterSpec{FilterSpec::ButterworthLowpass, 2, 0, 0}), std::invalid_argument);
+    EXPECT_THROW(FrequencyFilter<>(FilterSpec{FilterSpec::Bandpass, 4, 2}), std::invalid_argument);
+    EXPECT_THROW(FilterBank<>({gauss, FilterSpec{FilterSpec::Notch, -1}}), std::invalid_argument);
+
+    MatrixXi item(20, 30);
+    for (int i = 0; i < 20; i++){
+        for (int j = 0; j < 30; j++){
+            item(i, j) = (i * 19 + j * 7) % 256;
+        }
+    }
+    /// the ideal filters match LowpassFilter and HighpassFilter, the smooth ones match FilterBank
+    EXPECT_EQ(FrequencyFilter<>(FilterSpec{FilterSpec::IdealLowpass, 4}).transform(item), LowpassFilter<>(4).transform(item));
+    EXPECT_EQ(FrequencyFilter<>(FilterSpec{FilterSpec::IdealHighpass, 4}).transform(item), HighpassFilter<>(4).transform(item));
+    auto images = FilterBank<>({gauss, butter, band, notch}).transform(item);
+    EXPECT_EQ(images[0], FrequencyFilter<>(gauss).transform(item));
+    EXPECT_EQ(images[1], FrequencyFilter<>(butter).transform(item));
+    EXPECT_EQ(images[2], FrequencyFilter<>(band).transform(item));
+    EXPECT_EQ(images[3], FrequencyFilter<>(notch).transform(item));
+
+    /// the lowpasses keep a constant image and remove a checkerboard (Nyquist frequency), the highpasses do the opposite
+    MatrixXi flat = MatrixXi::Constant(20, 30, 100);
+    MatrixXi checker(20, 30);
+    for (int i = 0; i < 20; i++){
+        for (int j = 0; j < 30; j++){
+            checker(i, j) = 100 + ((i + j) % 2 ? -50 : 50);
+        }
+    }
+    MatrixXi alternating = checker - flat;
+    for (FilterSpec spec : {FilterSpec{FilterSpec::GaussianLowpass, 2.5}, FilterSpec{FilterSpec::ButterworthLowpass, 2.5, 0, 3}}){
+        EXPECT_LE((FrequencyFilter<>(spec).transform(flat) - flat).cwiseAbs().maxCoeff(), 1);
+        EXPECT_LE((FrequencyFilter<float>(spec).transform(flat) - flat).cwiseAbs().maxCoeff(), 1);
+        EXPECT_LE((FrequencyFilter<>(spec).transform(checker) - flat).cwiseAbs().maxCoeff(), 1);
+    }
+    for (FilterSpec spec : {FilterSpec{FilterSpec::GaussianHighpass, 2.5}, butter}){
+        EXPECT_LE(FrequencyFilter<>(spec).transform(flat).cwiseAbs().maxCoeff(), 1);
+        EXPECT_LE(FrequencyFilter<float>(spec).transform(flat).cwiseAbs().maxCoeff(), 1);
+        EXPECT_LE((FrequencyFilter<>(spec).transform(checker) - alternating).cwiseAbs().maxCoeff(), 1);
+    }
+    /// the band-pass removes both, the notch keeps the constant image
+    EXPECT_LE(FrequencyFilter<>(band).transform(flat).cwiseAbs().maxCoeff(), 1);
+    EXPECT_LE(FrequencyFilter<>(band).transform(checker).cwiseAbs().maxCoeff(), 1);
+    EXPECT_LE((FrequencyFilter<>(notch).transform(flat) - flat).cwiseAbs().maxCoeff(), 2);
+}
+
+/**
+ * @brief Check the magnitude, phase and log-magnitude of FFT1D and FFT2D (real-valued, computed from the spectrum)
+ * 
+ */
+TEST_F(TransformTest, FFTMAGNITUDEPHASE){
+    MatrixXi item(6, 10);
+    for (int i = 0; i < 6; i++){
+        for (int j = 0; j < 10; j++){
+            item(i, j) = (i * 37 + j * 11) % 256;
+        }
+    }
+    FFT2D<> fft2;
+    ComplexMatrix<double> freq = fft2.transform(item);
+    RealMatrix<double> magnitude = FFT2D<>::getMagnitude(freq);
+    RealMatrix<double> phase = FFT2D<>::getPhase(freq);
+    RealMatrix<double> logMagnitude = FFT2D<>::getLogMagnitude(freq);
+    ASSERT_EQ(magnitude.rows(), 6);
+    ASSERT_EQ(phase.cols(), 10);
+    for (int i = 0; i < 6; i++){
+        for (int j = 0; j < 10; j++){
+            EXPECT_DOUBLE_EQ(magnitude(i, j), std::abs(freq(i, j)));
+            EXPECT_DOUBLE_EQ(phase(i, j), std::arg(freq(i, j)));
+            EXPECT_DOUBLE_EQ(logMagnitude(i, j), std::log(1 + std::abs(freq(i, j))));
+        }
+    }
+    FFT2D<float> half(1, true);
+    EXPECT_EQ(FFT2D<float>::getMagnitude(half.transform(item)).cols(), 6);
+
+    FFT1D<float> fft1;
+    ComplexRow<float> row = fft1.transform(item.row(0));
+    RealRow<float> rowMagnitude = FFT1D<float>::getMagnitude(row);
+    RealRow<float> rowPhase = FFT1D<float>::getPhase(row);
+    ASSERT_EQ(rowMagnitude.size(), 10);
+    for (int j = 0; j < 10; j++){
+        EXPECT_FLOAT_EQ(rowMagnitude(j), std::abs(row(j)));
+        EXPECT_FLOAT_EQ(rowPhase(j), std::arg(row(j)));
+        EXPECT_FLOAT_EQ(FFT1D<float>::getLogMagnitude(row)(j), std::log1p(std::abs(row(j))));
+    }
+}
+
+/**
+ * @brief Check the tiled FFT convolution against a direct convolution (many tiles, several threads, odd and even kernels)
+ * 
+ */
+TEST_F(TransformTest, FFTCONVOLUTION){
+    MatrixXi item(37, 53);
+    for (int i = 0; i < 37; i++){
+        for (int j = 0; j < 53; j++){
+            item(i, j) = (i * 29 + j * 11 + i * j) % 256;
+        }
+    }
+    auto direct = [&](const MatrixXd& kernel){
+        int kr = kernel.rows(), kc = kernel.cols();
+        MatrixXd out = MatrixXd::Zero(item.rows(), item.cols());
+        for (int i = 0; i < item.rows(); i++){
+            for (int j = 0; j < item.cols(); j++){
+                for (int a = 0; a < kr; a++){
+                    for (int b = 0; b < kc; b++){
+                        int x = i + kr / 2 - a, y = j + kc / 2 - b;
+                        if (x >= 0 && x < item.rows() && y >= 0 && y < item.cols()){
+                            out(i, j) += kernel(a, b) * item(x, y);
+                        }
+                    }
+                }
+            }
+        }
+        return out;
+    };
+
+    for (auto shape : {std::make_pair(1, 1), std::make_pair(3, 5), std::make_pair(4, 2), std::make_pair(9, 9), std::make_pair(40, 60)}){
+        MatrixXd kernel(shape.first, shape.second);
+        for (int a = 0; a < kernel.rows(); a++){
+            for (int b = 0; b < kernel.cols(); b++){
+                kernel(a, b) = std::sin(a * 1.3 + b * 0.7 + 1);
+            }
+        }
+        MatrixXd expected = direct(kernel);
+        double scale = expected.cwiseAbs().maxCoeff();
+        for (int threads : {1, 3}){
+            ThreadPool::setGlobalThreads(threads);
+            for (int tile : {0, 16, 64}){
+                if (tile != 0 && (tile < kernel.rows() || tile < kernel.cols())){
+                    EXPECT_THROW(FFTConvolution<>(kernel, tile), std::invalid_argument);
+                    continue;
+                }
+                FFTConvolution<> conv(kernel, tile);
+                MatrixXd out = conv.transform(item);
+                ASSERT_EQ(out.rows(), item.rows());
+                ASSERT_EQ(out.cols(), item.cols());
+                EXPECT_LT((out - expected).cwiseAbs().maxCoeff(), 1e-9 * scale);
+                /// the kernel spectrum is reused for the next image
+                EXPECT_LT((conv.transform(item) - expected).cwiseAbs().maxCoeff(), 1e-9 * scale);
+                MatrixXd outFloat = FFTConvolution<float>(kernel, tile).transform(item);
+                EXPECT_LT((outFloat - expected).cwiseAbs().maxCoeff(), 1e-4 * scale);
+            }
+        }
+    }
+    ThreadPool::setGlobalThreads(0);
+    EXPECT_THROW(FFTConvolution<>{MatrixXd()}, std::invalid_argument);
+
+    /// empty images give empty results, also with kernels larger than the image
+    for (auto shape : {std::make_pair(0, 0), std::make_pair(0, 5), std::make_pair(4, 0)}){
+        MatrixXd out = FFTConvolution<>(MatrixXd::Ones(3, 3)).transform(MatrixXi(shape.first, shape.second));
+        EXPECT_EQ(out.rows(), shape.first);
+        EXPECT_EQ(out.cols(), shape.second);
+    }
+}
+
+/**
+ * @brief Check the direct, separable and FFT convolutions against each other, and the choice of the algorithm
+ * 
+ */
+TEST_F(TransformTest, CONVOLUTION){
+    MatrixXi item(41, 29);
+    for (int i = 0; i < 41; i++){
+        for (int j = 0; j < 29; j++){
+            item(i, j) = (i * 23 + j * 13 + i * j) % 256;
+        }
+    }
+    Eigen::VectorXd u(5), v(7);
+    u << 1, 4, 6, 4, 1;
+    v << -1, 2, 0.5, 3, 0, -2, 1;
+    MatrixXd separable = u * v.transpose();
+    MatrixXd ripple = separable;
+    ripple(1, 2) += 0.25;
+
+    for (const MatrixXd& kernel : {separable, ripple, MatrixXd(MatrixXd::Constant(1, 1, 2.)), MatrixXd(v.transpose())}){
+        Convolution<> direct(kernel, ConvolutionMethod::Direct);
+        MatrixXd expected = FFTConvolution<>(kernel).transform(item);
+        double scale = expected.cwiseAbs().maxCoeff();
+        for (int threads : {1, 3}){
+            ThreadPool::setGlobalThreads(threads);
+            EXPECT_LT((direct.transform(item) - expected).cwiseAbs().maxCoeff(), 1e-9 * scale);
+            EXPECT_LT((Convolution<>(kernel).transform(item) - expected).cwiseAbs().maxCoeff(), 1e-9 * scale);
+            EXPECT_LT((Convolution<>(kernel, ConvolutionMethod::FFT).transform(item) - expected).cwiseAbs().maxCoeff(), 1e-9 * scale);
+            EXPECT_LT((Convolution<float>(kernel, ConvolutionMethod::Direct).transform(item) - expected).cwiseAbs().maxCoeff(), 1e-5 * scale);
+            if (Convolution<>(kernel).isSeparable()){
+                EXPECT_LT((Convolution<>(kernel, ConvolutionMethod::Separable).transform(item) - expected).cwiseAbs().maxCoeff(), 1e-9 * scale);
+            }
+        }
+    }
+    ThreadPool::setGlobalThreads(0);
+
+    EXPECT_TRUE(Convolution<>(separable).isSeparable());
+    EXPECT_FALSE(Convolution<>(ripple).isSeparable());
+    EXPECT_THROW(Convolution<>(ripple, ConvolutionMethod::Separable), std::invalid_argument);
+    EXPECT_THROW(Convolution<>{MatrixXd()}, std::invalid_argument);
+
+    /// small kernels are never convolved with FFTs, large ones on large images are
+    EXPECT_NE(Convolution<>(MatrixXd::Ones(3, 3)).choose(1024, 1024), ConvolutionMethod::FFT);
+    EXPECT_NE(Convolution<>(ripple).choose(1024, 1024), ConvolutionMethod::FFT);
+    EXPECT_EQ(Convolution<>(separable).choose(1024, 1024), ConvolutionMethod::Separable);
+    MatrixXd large = MatrixXd::Random(41, 41);
+    EXPECT_EQ(Convolution<>(large).choose(1024, 1024), ConvolutionMethod::FFT);
+    EXPECT_EQ(Convolution<>(large, ConvolutionMethod::Direct).choose(1024, 1024), ConvolutionMethod::Direct);
+
+    /// empty images give empty results with every method
+    for (ConvolutionMethod method : {ConvolutionMethod::Auto, ConvolutionMethod::Direct, ConvolutionMethod::Separable, ConvolutionMethod::FFT}){
+        for (auto shape : {std::make_pair(0, 0), std::make_pair(0, 5), std::make_pair(4, 0)}){
+            MatrixXd out = Convolution<>(MatrixXd::Ones(3, 3), method).transform(MatrixXi(shape.first, shape.second));
+            EXPECT_EQ(out.rows(), shape.first);
+            EXPECT_EQ(out.cols(), shape.second);
+        }
+    }
+}
+
+/**
+ * @brief Check transform(item, out) against transform(item), the reuse of the output buffer and the result views
+ * 
+ */
+TEST_F(TransformTest, TRANSFORMINTO){
+    MatrixXi item(24, 18);
+    for (int i = 0; i < 24; i++){
+        for (int j = 0; j < 18; j++){
+            item(i, j) = (i * 43 + j * 19) % 256;
+        }
+    }
+
+    Thresholding threshold(50, 180);
+    LowpassFilter<> lowpass(5);
+    HighpassFilter<float> highpass(5);
+    FrequencyFilter<> gaussian(FilterSpec{FilterSpec::GaussianLowpass, 4});
+    for (Transform<MatrixXi, MatrixXi>* filter : std::vector<Transform<MatrixXi, MatrixXi>*>{&threshold, &lowpass, &highpass, &gaussian}){
+        MatrixXi expected = filter->transform(item);
+        MatrixXi out(24, 18);
+        const int* buffer = out.data();
+        for (int frame = 0; frame < 3; frame++){
+            filter->transform(item, out);
+            EXPECT_EQ(out, expected);
+            EXPECT_EQ(out.data(), buffer);
+        }
+    }
+
+    FFT2D<> fft;
+    ComplexMatrix<double> spectrum = fft.transform(item);
+    ComplexMatrix<double> spectrumOut;
+    fft.transform(item, spectrumOut);
+    EXPECT_EQ(spectrumOut, spectrum);
+    const std::complex<double>* spectrumBuffer = spectrumOut.data();
+    fft.transform(item, spectrumOut);
+    EXPECT_EQ(spectrumOut.data(), spectrumBuffer);
+
+    iFFT2D<> ifft;
+    Eigen::Matrix<int, -1, -1> image;
+    ifft.transform(spectrum, image);
+    EXPECT_EQ(image, item);
+
+    Convolution<> convolution(MatrixXd::Ones(3, 3));
+    FFTConvolution<float> fftConvolution(MatrixXd::Ones(3, 3));
+    MatrixXd convolved(24, 18);
+    const double* convolvedBuffer = convolved.data();
+    convolution.transform(item, convolved);
+    EXPECT_EQ(convolved.data(), convolvedBuffer);
+    EXPECT_EQ(convolved, convolution.transform(item));
+    MatrixXd direct = convolved;
+    fftConvolution.transform(item, convolved);
+    EXPECT_EQ(convolved, fftConvolution.transform(item));
+    EXPECT_LT((convolved - direct).cwiseAbs().maxCoeff(), 1e-2);
+
+    /// transforms without their own implementation use the default one
+    Histogram histogram;
+    MatrixXd hist;
+    histogram.transform(item, hist);
+    EXPECT_EQ(hist, histogram.transform(item));
+}
+
+/**
+ * @brief Check that one const transform used by several threads at once, each with its own workspace, gives the serial results
+ * 
+ */
+TEST_F(TransformTest, SHAREDTRANSFORM){
+    MatrixXi item(33, 48);
+    for (int i = 0; i < 33; i++){
+        for (int j = 0; j < 48; j++){
+            item(i, j) = (i * 29 + j * 13) % 256;
+        }
+    }
+    const FFT2D<> fft;
+    const FrequencyFilter<float> gaussian(FilterSpec{FilterSpec::GaussianLowpass, 6});
+    const FilterBank<> bank({FilterSpec{FilterSpec::IdealLowpass, 4}, FilterSpec{FilterSpec::ButterworthHighpass, 8, 0, 2}});
+    const Convolution<> convolution(MatrixXd::Ones(9, 9), ConvolutionMethod::FFT);
+    ThreadPool::setGlobalThreads(1);
+    ComplexMatrix<double> spectrum = fft.transform(item);
+    MatrixXi filtered = gaussian.transform(item);
+    std::vector<MatrixXi> sweep = bank.transform(item);
+    MatrixXd convolved = convolution.transform(item);
+
+    /// the shared pool runs the loops of one caller at a time, the others run theirs serially
+    for (int poolThreads : {1, 3}){
+        ThreadPool::setGlobalThreads(poolThreads);
+        std::vector<int> matches(4, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++){
+            threads.emplace_back([&, t]() {
+                TransformWorkspace workspace;
+                ComplexMatrix<double> spectrumOut;
+                MatrixXi filteredOut;
+                std::vector<MatrixXi> sweepOut;
+                MatrixXd convolvedOut;
+                for (int frame = 0; frame < 3; frame++){
+                    fft.transform(item, spectrumOut, workspace);
+                    gaussian.transform(item, filteredOut, workspace);
+                    bank.transform(item, sweepOut, workspace);
+                    convolution.transform(item, convolvedOut, workspace);
+                    matches[t] += (spectrumOut == spectrum && filteredOut == filtered && sweepOut == sweep &&
+                                   (convolvedOut - convolved).cwiseAbs().maxCoeff() < 1e-9);
+                }
+            });
+        }
+        for (auto& thread : threads){
+            thread.join();
+        }
+        EXPECT_EQ(matches, std::vector<int>(4, 3));
+    }
+    ThreadPool::setGlobalThreads(0);
+}
+
+/**
+ * @brief Check the transforms on 8-bit and 16-bit pixels against int pixels
+ * 
+ */
+TEST_F(TransformTest, PIXELTYPES){
+    MatrixXi item(20, 26);
+    for (int i = 0; i < 20; i++){
+        for (int j = 0; j < 26; j++){
+            item(i, j) = (i * 41 + j * 23) % 256;
+        }
+    }
+    MatrixXu8 item8 = item.cast<uint8_t>();
+    MatrixXu16 item16 = (item * 200).cast<uint16_t>();
+
+    /// thresholds out of the range of the pixels clamp to its bounds
+    EXPECT_EQ(Thresholding<uint8_t>(-10, 1000).transform(item8), item8);
+    EXPECT_EQ(Thresholding<uint8_t>(50, 180).transform(item8).cast<int>().eval(), Thresholding<>(50, 180).transform(item));
+    EXPECT_EQ(Thresholding<uint8_t>(300, 400).transform(item8).minCoeff(), 255);
+    EXPECT_EQ(Thresholding<uint16_t>(5000, 40000).transform(item16).cast<int>().eval(),
+              Thresholding<>(5000, 40000).transform(item * 200));
+    EXPECT_EQ(Histogram<uint8_t>().transform(item8), Histogram<>().transform(item));
+
+    /// the filters saturate their output to the range of the pixels
+    MatrixXi highpass = HighpassFilter<>(3).transform(item);
+    EXPECT_LT(highpass.minCoeff(), 0);
+    HighpassFilter<double, uint8_t> highpass8(3);
+    EXPECT_EQ(highpass8.transform(item8).cast<int>().eval(), highpass.cwiseMax(0).cwiseMin(255));
+    FilterSpec spec{FilterSpec::GaussianLowpass, 5};
+    FrequencyFilter<float, uint8_t> gaussian8(spec);
+    EXPECT_EQ(gaussian8.transform(item8).cast<int>().eval(), FrequencyFilter<float>(spec).transform(item).cwiseMax(0).cwiseMin(255));
+    LowpassFilter<double, uint16_t> lowpass16(6);
+    EXPECT_EQ(lowpass16.transform(item16).cast<int>().eval(), LowpassFilter<>(6).transform(item * 200).cwiseMax(0).cwiseMin(65535));
+    FilterBank<float, uint8_t> bank8({spec});
+    EXPECT_EQ(bank8.transform(item8)[0], gaussian8.transform(item8));
+}
+
 /**
  * @brief Check correctness of the lowpass filter
  * 
@@ -196,6 +1312,10 @@ TEST_F(TransformTest, LOWPASSFILTER){
     EXPECT_EQ(mat2(0, 1), 12);
     EXPECT_EQ(mat2(1, 0), 21);
     EXPECT_EQ(mat2(1, 1), 22);
+
+    /// the lowpass command builds a lowpass filter
+    std::unique_ptr<Transform<MatrixXu8, MatrixXu8>> parsed(LowpassFilterParser().parse({"in.png", "out.png", "5"}));
+    EXPECT_NE((dynamic_cast<LowpassFilter<double, uint8_t>*>(parsed.get())), nullptr);
 }
 
 /**
@@ -1,4 +1,7 @@
 #include "transforms.hpp"
+#include <map>
+#include <mutex>
+#include <tuple>
 
 // Transform
 
@@ -6,119 +9,536 @@
 // template <typename TInput, typename TOutput>
 // TOutput Transform<TInput, TOutput>::transform(const TInput& item_) = 0;
 
-// Thresholding
+// Workspace
+
+void TransformWorkspace::prepareThreads(int count) {
+    while (int(threads.size()) < count) {
+        threads.emplace_back(new TransformWorkspace());
+    }
+}
 
-Thresholding::Thresholding(const int thr_min_, const int thr_max_) {
-    thr_min = thr_min_;
-    thr_max = thr_max_;
+TransformWorkspace &TransformWorkspace::thread(int index) {
+    return *threads[index];
+}
+
+TransformWorkspace &TransformWorkspace::local() {
+    thread_local TransformWorkspace workspace;
+    return workspace;
+}
 
-    if (thr_min > thr_max) {
+/*buffers of a workspace that are used at the same time get different slots*/
+enum ScratchSlot {
+    SpectrumScratch, RowScratch, GatherScratch, ColumnsScratch, CopyScratch,
+    TileScratch, TileRowsScratch, TileColumnsScratch, PaddedScratch, OutputScratch, PassScratch, CountScratch,
+    GrownCountScratch, RangeScratch
+};
+
+// Thresholding
+
+template <typename P>
+Thresholding<P>::Thresholding(const int thr_min_, const int thr_max_) {
+    if (thr_min_ > thr_max_) {
         throw std::invalid_argument(
             "Minimum value of the threshold cannot be bigger then the maximum");
     }
+
+    /*thresholds out of the range of the pixels clamp them to the bounds of the range*/
+    thr_min = saturatePixel<P>(thr_min_);
+    thr_max = saturatePixel<P>(thr_max_);
 }
 
-MatrixXi Thresholding::transform(const MatrixXi &item) {
-    int nrows = item.rows();
-    int ncols = item.cols();
+template <typename P>
+PixelMatrix<P> Thresholding<P>::transform(const PixelMatrix<P> &item) const {
+    PixelMatrix<P> thr_item;
+    transform(item, thr_item);
+    return thr_item;
+}
 
-    MatrixXi thr_item(nrows, ncols);
+/*frames smaller than this are processed by the calling thread, waking the pool would cost more than the pass*/
+static const size_t parallelPixelBytes = 1 << 20;
 
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            if (item(i, j) < thr_min)
-                thr_item(i, j) = thr_min;
-            else if (item(i, j) > thr_max)
-                thr_item(i, j) = thr_max;
-            else
-                thr_item(i, j) = item(i, j);
-        }
+/*kernel(in, out, n) over the contiguous pixels of a matrix, split into stripes of columns over the pool for large
+  frames (out may be in)*/
+template <typename P, typename K>
+static void pixelStripes(const PixelMatrix<P> &item, P out[], const K &kernel) {
+    const P *in = item.data();
+    size_t nrows = item.rows();
+    if (item.size() * sizeof(P) < parallelPixelBytes) {
+        kernel(in, out, item.size());
+        return;
     }
+    ThreadPool::global().parallelFor(0, item.cols(), [&](int begin, int end, int) {
+        kernel(in + begin * nrows, out + begin * nrows, (end - begin) * nrows);
+    });
+}
 
-    return thr_item;
+template <typename P>
+void Thresholding<P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &thr_item) const {
+    /*no-op when thresholding in place*/
+    thr_item.resize(item.rows(), item.cols());
+
+    PixelClamp<P> clamp = pixelKernel().clamp<P>();
+    pixelStripes(item, thr_item.data(), [&](const P *in, P *out, size_t n) {
+        clamp(in, out, n, thr_min, thr_max);
+    });
+}
+
+template <typename P>
+void Thresholding<P>::transformInPlace(PixelMatrix<P> &item) const {
+    transform(item, item);
+}
+
+template <typename P>
+LUTTransform Thresholding<P>::toLUT() const {
+    int low = thr_min, high = thr_max;
+    return LUTTransform::fromFunction([=](int v) { return std::min(std::max(v, low), high); });
+}
+
+template <typename P>
+Thresholding<P> Thresholding<P>::then(const Thresholding<P> &next) const {
+    return Thresholding<P>(std::min(std::max(thr_min, next.thr_min), next.thr_max),
+                           std::min(std::max(thr_max, next.thr_min), next.thr_max));
 }
 
 // Histogram
 
-Histogram::Histogram() = default;
+template <typename P>
+Histogram<P>::Histogram() = default;
 
-MatrixXd Histogram::transform(const MatrixXi &item) {
-    int nrows = item.rows();
+/*consecutive values are counted in different sub-histograms, so that runs of equal values do not wait for the
+  store of the previous increment of their bin; they are kept while they fit in the L1 cache*/
+static const int histogramLanes = 4;
+static const int laneBins = 2048;
+
+/*counts[b] = number of values v with bin(v) == b, the count table has lanes * bins entries*/
+template <typename V, typename Bin>
+static void countValues(const V in[], size_t n, int bins, int lanes, uint32_t counts[], const Bin &bin) {
+    std::fill(counts, counts + size_t(lanes) * bins, 0);
+    size_t k = 0;
+    if (lanes == histogramLanes) {
+        uint32_t *c1 = counts + bins, *c2 = c1 + bins, *c3 = c2 + bins;
+        for (; k + 4 <= n; k += 4) {
+            counts[bin(in[k])]++;
+            c1[bin(in[k + 1])]++;
+            c2[bin(in[k + 2])]++;
+            c3[bin(in[k + 3])]++;
+        }
+        for (int b = 0; b < bins; b++) {
+            counts[b] += c1[b] + c2[b] + c3[b];
+        }
+    }
+    for (; k < n; k++) {
+        counts[bin(in[k])]++;
+    }
+}
+
+/*counts of the values of a matrix: every stripe of columns has its own count table (in the workspace of its
+  index), merged into the first one, which is returned*/
+template <typename V, typename Bin>
+static const uint32_t *countMatrix(const Eigen::Matrix<V, Dynamic, Dynamic> &item, int bins, const Bin &bin,
+                                   TransformWorkspace &workspace) {
+    size_t nrows = item.rows();
     int ncols = item.cols();
-    int size = nrows * ncols;
+    const V *data = item.data();
+    int lanes = (bins <= laneBins) ? histogramLanes : 1;
 
-    int min_val = item.minCoeff();
-    int max_val = item.maxCoeff();
+    ThreadPool &pool = ThreadPool::global();
+    int stripes = (item.size() * sizeof(V) < parallelPixelBytes) ? 1 : std::min(pool.size(), ncols);
+    workspace.prepareThreads(stripes);
+    pool.parallelFor(0, stripes, [&](int begin, int end, int) {
+        for (int s = begin; s < end; s++) {
+            size_t colBegin = size_t(ncols) * s / stripes, colEnd = size_t(ncols) * (s + 1) / stripes;
+            uint32_t *counts = workspace.thread(s).buffer<uint32_t>(CountScratch, size_t(lanes) * bins);
+            countValues(data + colBegin * nrows, (colEnd - colBegin) * nrows, bins, lanes, counts, bin);
+        }
+    });
+    uint32_t *counts = workspace.thread(0).buffer<uint32_t>(CountScratch, size_t(lanes) * bins);
+    for (int s = 1; s < stripes; s++) {
+        const uint32_t *stripe = workspace.thread(s).buffer<uint32_t>(CountScratch, size_t(lanes) * bins);
+        for (int b = 0; b < bins; b++) {
+            counts[b] += stripe[b];
+        }
+    }
+    return counts;
+}
 
-    MatrixXd hist = MatrixXd::Zero(1, max_val - min_val + 1);
+/*count table of the values met so far by a stripe: bin b of lane l, for the value low + b, is counts[b * lanes + l]*/
+struct RangeCounts {
+    long long low;
+    size_t bins;
+    int lanes;
+    int slot;
+    uint32_t *counts;
+};
 
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            hist(0, item(i, j) - min_val) += 1. / size;
+/*values whose range is unknown are counted by chunks that stay in the L1 cache: the range of a chunk is found
+  first, and the table is grown when the chunk falls outside of it*/
+static const size_t rangeChunk = 1024;
+
+/*the table at least doubles on the side where it grows, so that a drifting range is copied a few times only.
+  It alternates between two slots of the workspace (a slot loses its content when it grows), and the lanes are
+  merged once the table no longer fits in the L1 cache.*/
+static void growRange(RangeCounts &range, long long minimum, long long maximum, TransformWorkspace &workspace) {
+    long long low = minimum, high = maximum;
+    if (range.bins > 0) {
+        long long span = range.bins;
+        long long oldHigh = range.low + span - 1;
+        low = (minimum < range.low) ? std::min(minimum, range.low - span) : range.low;
+        high = (maximum > oldHigh) ? std::max(maximum, oldHigh + span) : oldHigh;
+    }
+    size_t bins = size_t(high - low + 1);
+    int lanes = (bins <= size_t(laneBins)) ? ((range.bins > 0) ? range.lanes : histogramLanes) : 1;
+    int slot = (range.bins > 0 && range.slot == CountScratch) ? GrownCountScratch : CountScratch;
+
+    uint32_t *counts = workspace.buffer<uint32_t>(slot, bins * lanes);
+    std::fill(counts, counts + bins * lanes, 0);
+    size_t offset = size_t(range.low - low);
+    for (size_t b = 0; b < range.bins; b++) {
+        for (int l = 0; l < range.lanes; l++) {
+            counts[(b + offset) * lanes + l % lanes] += range.counts[b * range.lanes + l];
+        }
+    }
+    range = RangeCounts{low, bins, lanes, slot, counts};
+}
+
+template <typename V>
+static void countRange(const V in[], size_t n, RangeCounts &range, TransformWorkspace &workspace) {
+    for (size_t start = 0; start < n; start += rangeChunk) {
+        const V *chunk = in + start;
+        size_t m = std::min(n - start, rangeChunk);
+        V minimum = chunk[0], maximum = chunk[0];
+        for (size_t k = 1; k < m; k++) {
+            minimum = std::min(minimum, chunk[k]);
+            maximum = std::max(maximum, chunk[k]);
+        }
+        if (range.bins == 0 || minimum < range.low || maximum > range.low + (long long)range.bins - 1) {
+            growRange(range, minimum, maximum, workspace);
+        }
+
+        uint32_t *counts = range.counts;
+        long long low = range.low;
+        size_t k = 0;
+        if (range.lanes == histogramLanes) {
+            for (; k + 4 <= m; k += 4) {
+                counts[size_t(chunk[k] - low) * 4]++;
+                counts[size_t(chunk[k + 1] - low) * 4 + 1]++;
+                counts[size_t(chunk[k + 2] - low) * 4 + 2]++;
+                counts[size_t(chunk[k + 3] - low) * 4 + 3]++;
+            }
+        }
+        for (; k < m; k++) {
+            counts[size_t(chunk[k] - low) * range.lanes]++;
         }
     }
+}
 
+/*counts of the values of a matrix from its minimum to its maximum, found in the same pass: every stripe of
+  columns grows its own table (in the workspace of its index), they are merged into a table of the workspace*/
+template <typename V>
+static const uint32_t *countMatrixRange(const Eigen::Matrix<V, Dynamic, Dynamic> &item, long long &low, int &bins,
+                                        TransformWorkspace &workspace) {
+    size_t nrows = item.rows();
+    int ncols = item.cols();
+    const V *data = item.data();
+
+    ThreadPool &pool = ThreadPool::global();
+    int stripes = (item.size() * sizeof(V) < parallelPixelBytes) ? 1 : std::min(pool.size(), ncols);
+    workspace.prepareThreads(stripes);
+    pool.parallelFor(0, stripes, [&](int begin, int end, int) {
+        for (int s = begin; s < end; s++) {
+            size_t colBegin = size_t(ncols) * s / stripes, colEnd = size_t(ncols) * (s + 1) / stripes;
+            TransformWorkspace &local = workspace.thread(s);
+            RangeCounts &range = *local.buffer<RangeCounts>(RangeScratch, 1);
+            range = RangeCounts{0, 0, 1, CountScratch, nullptr};
+            countRange(data + colBegin * nrows, (colEnd - colBegin) * nrows, range, local);
+        }
+    });
+
+    long long high = std::numeric_limits<long long>::min();
+    low = std::numeric_limits<long long>::max();
+    for (int s = 0; s < stripes; s++) {
+        const RangeCounts &range = *workspace.thread(s).buffer<RangeCounts>(RangeScratch, 1);
+        if (range.bins > 0) {
+            low = std::min(low, range.low);
+            high = std::max(high, range.low + (long long)range.bins - 1);
+        }
+    }
+    bins = int(high - low + 1);
+    uint32_t *counts = workspace.buffer<uint32_t>(CountScratch, bins);
+    std::fill(counts, counts + bins, 0);
+    for (int s = 0; s < stripes; s++) {
+        const RangeCounts &range = *workspace.thread(s).buffer<RangeCounts>(RangeScratch, 1);
+        uint32_t *stripe = counts + (range.low - low);
+        for (size_t b = 0; b < range.bins; b++) {
+            for (int l = 0; l < range.lanes; l++) {
+                stripe[b] += range.counts[b * range.lanes + l];
+            }
+        }
+    }
+    return counts;
+}
+
+template <typename P>
+MatrixXd Histogram<P>::transform(const PixelMatrix<P> &item) const {
+    MatrixXd hist;
+    transform(item, hist, TransformWorkspace::local());
     return hist;
 }
 
-// Fourier Transform
+template <typename P>
+void Histogram<P>::transform(const PixelMatrix<P> &item, MatrixXd &hist) const {
+    transform(item, hist, TransformWorkspace::local());
+}
 
-/* define mainbody of FFT1D */
-void mainFFT1D(std::complex<float> signal[], int start, int fin, int step1,
-               float inv, std::complex<float> buffer[]) {
-    int n = (fin - start) / step1 + 1;
-    if (n == 1) {  // Termination condition: only one element left in the
-                   // considered array
-        return;
+template <typename P>
+void Histogram<P>::transform(const PixelMatrix<P> &item, MatrixXd &hist, TransformWorkspace &workspace) const {
+    if (item.size() == 0) {
+        throw std::invalid_argument("Cannot compute the histogram of an empty image");
     }
-    mainFFT1D(signal, start, fin, 2 * step1, inv,
-              buffer);  // recursively call on even indices
-    mainFFT1D(signal, start + step1, fin, 2 * step1, inv,
-              buffer);  // recursively call on odd indices
 
-    /*building factor*/
-    std::complex<float> subfactor =
-        std::polar(float(1), float(inv * 2 * M_PI / float(n)));
-    std::complex<float> factor = 1;
+    /*8-bit pixels, and 16-bit pixels of images larger than a quarter of their range, are counted in a table of
+      the whole range. Other images are counted in tables grown to the range of their values. In both cases the
+      minimum and the maximum are the first and the last non-empty bins: the image is read once.*/
+    bool wholeRange = false;
+    if constexpr (sizeof(P) < sizeof(int)) {
+        wholeRange = item.size() >= int(std::numeric_limits<P>::max()) / 4;
+    }
+    int bins;
+    const uint32_t *counts;
+    if (wholeRange) {
+        int low = std::numeric_limits<P>::lowest();
+        bins = int(std::numeric_limits<P>::max()) - low + 1;
+        counts = countMatrix(item, bins, [low](P value) { return int(value) - low; }, workspace);
+    } else {
+        long long low;
+        counts = countMatrixRange(item, low, bins, workspace);
+    }
 
-    for (int k = 0; k < n; k++) {
-        buffer[k] = signal[start + k * step1];
+    int first = 0, last = bins - 1;
+    while (counts[first] == 0) {
+        first++;
     }
-    for (int k = 0; k < n / 2; k++) {
-        signal[start + k * step1] = buffer[2 * k] + factor * buffer[2 * k + 1];
-        signal[start + (k + n / 2) * step1] =
-            buffer[2 * k] - factor * buffer[2 * k + 1];
-        factor *= subfactor;
+    while (counts[last] == 0) {
+        last--;
     }
+    hist.resize(1, last - first + 1);
+    double norm = 1. / item.size();
+    for (int b = first; b <= last; b++) {
+        hist(0, b - first) = counts[b] * norm;
+    }
+}
+
+// BinnedHistogram
+
+template <typename V>
+BinnedHistogram<V>::BinnedHistogram(int bins_, double low_, double high_) {
+    if (bins_ < 1) {
+        throw std::invalid_argument("Number of bins of the histogram must be positive");
+    }
+    if (!(low_ < high_)) {
+        throw std::invalid_argument("Lower bound of the histogram range must be smaller than the upper bound");
+    }
+    bins = bins_;
+    low = low_;
+    high = high_;
+}
+
+template <typename V>
+MatrixXd BinnedHistogram<V>::transform(const PixelMatrix<V> &item) const {
+    MatrixXd hist;
+    transform(item, hist, TransformWorkspace::local());
+    return hist;
+}
+
+template <typename V>
+void BinnedHistogram<V>::transform(const PixelMatrix<V> &item, MatrixXd &hist) const {
+    transform(item, hist, TransformWorkspace::local());
+}
+
+template <typename V>
+void BinnedHistogram<V>::transform(const PixelMatrix<V> &item, MatrixXd &hist, TransformWorkspace &workspace) const {
+    if (item.size() == 0) {
+        throw std::invalid_argument("Cannot compute the histogram of an empty matrix");
+    }
+
+    /*bin index floor((v - low) * bins / (high - low)) with the reciprocal of the bin width precomputed, clamped
+      to the first and the last bins (float values are binned in single precision)*/
+    using R = typename std::conditional<std::is_same<V, float>::value, float, double>::type;
+    const R origin = R(low), scale = R(bins / (high - low)), last = R(bins - 1);
+    const uint32_t *counts = countMatrix(item, bins, [=](V value) {
+        return int(std::max(R(0), std::min((R(value) - origin) * scale, last)));
+    }, workspace);
+
+    hist.resize(1, bins);
+    double norm = 1. / item.size();
+    for (int b = 0; b < bins; b++) {
+        hist(0, b) = counts[b] * norm;
+    }
+}
+
+// Lookup tables
+
+LUTTransform::LUTTransform() {
+    for (int v = 0; v < 256; ++v) {
+        table[v] = uint8_t(v);
+    }
+}
+
+LUTTransform::LUTTransform(const std::array<uint8_t, 256> &table_) : table(table_) {}
+
+const std::array<uint8_t, 256> &LUTTransform::getTable() const {
+    return table;
 }
 
-FFT1D::FFT1D(int n) {
+LUTTransform LUTTransform::then(const LUTTransform &next) const {
+    std::array<uint8_t, 256> composed;
+    for (int v = 0; v < 256; ++v) {
+        composed[v] = next.table[table[v]];
+    }
+    return LUTTransform(composed);
+}
+
+MatrixXu8 LUTTransform::transform(const MatrixXu8 &item) const {
+    MatrixXu8 out;
+    transform(item, out);
+    return out;
+}
+
+void LUTTransform::transform(const MatrixXu8 &item, MatrixXu8 &out) const {
+    out.resize(item.rows(), item.cols());
+    PixelLookup lookup = pixelKernel().lookup8;
+    pixelStripes(item, out.data(), [&](const uint8_t *in, uint8_t *result, size_t n) {
+        lookup(in, result, n, table.data());
+    });
+}
+
+void LUTTransform::transformInPlace(MatrixXu8 &item) const {
+    transform(item, item);
+}
+
+GammaCorrection::GammaCorrection(double gamma) {
+    if (!(gamma > 0)) {
+        throw std::invalid_argument("Gamma must be positive");
+    }
+    table = fromFunction([gamma](int v) { return 255 * std::pow(v / 255., gamma); }).getTable();
+}
+
+ContrastStretch::ContrastStretch(int low, int high) {
+    if (low >= high) {
+        throw std::invalid_argument("Lower bound of the contrast stretch must be smaller than the upper bound");
+    }
+    double scale = 255. / (high - low);
+    table = fromFunction([=](int v) { return (v - low) * scale; }).getTable();
+}
+
+/*table[v] = 255 (cdf(v) - cdf(first)) / (total - cdf(first)) for the pixel values v >= first, where cdf(v) is the sum of
+  the bins of the values up to v and first is the first non-empty bin; counts[b] is the bin of the value low + b*/
+template <typename C>
+static std::array<uint8_t, 256> equalizationTable(const C counts[], int low, int bins) {
+    std::array<uint8_t, 256> table;
+    int first = 0;
+    while (first < bins - 1 && counts[first] == 0) {
+        first++;
+    }
+    double total = 0;
+    for (int b = 0; b < bins; b++) {
+        total += counts[b];
+    }
+    double base = counts[first];
+    if (total <= base) {
+        /*a single pixel value is left unchanged*/
+        for (int v = 0; v < 256; ++v) {
+            table[v] = uint8_t(v);
+        }
+        return table;
+    }
+    double cdf = 0, scale = 255. / (total - base);
+    for (int v = 0; v < 256; ++v) {
+        int b = v - low;
+        if (b >= 0 && b < bins) {
+            cdf += counts[b];
+        }
+        table[v] = (b < first) ? 0 : saturatePixel<uint8_t>((cdf - base) * scale);
+    }
+    return table;
+}
+
+HistogramEqualization::HistogramEqualization() = default;
+
+LUTTransform HistogramEqualization::table(const MatrixXd &histogram, int low) {
+    if (histogram.rows() != 1 || histogram.cols() == 0 || low < 0 || low + histogram.cols() > 256) {
+        throw std::invalid_argument("Equalization requires the histogram of 8-bit pixels");
+    }
+    return LUTTransform(equalizationTable(histogram.data(), low, histogram.cols()));
+}
+
+MatrixXu8 HistogramEqualization::transform(const MatrixXu8 &item) const {
+    MatrixXu8 out;
+    transform(item, out, TransformWorkspace::local());
+    return out;
+}
+
+void HistogramEqualization::transform(const MatrixXu8 &item, MatrixXu8 &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+void HistogramEqualization::transform(const MatrixXu8 &item, MatrixXu8 &out, TransformWorkspace &workspace) const {
+    if (item.size() == 0) {
+        throw std::invalid_argument("Cannot equalize an empty image");
+    }
+    /*the counts of the 256 pixel values, as in Histogram<uint8_t> (without the rescaling to fractions)*/
+    const uint32_t *counts = countMatrix(item, 256, [](uint8_t value) { return int(value); }, workspace);
+    LUTTransform(equalizationTable(counts, 0, 256)).transform(item, out);
+}
+
+// Fourier Transform
+
+/* define mainbody of FFT1D */
+template <typename T>
+void mainFFT1D(std::complex<T> signal[], int start, int fin, int step1,
+               T inv, std::complex<T> buffer[]) {
+    int n = (fin - start) / step1 + 1;
+    fftBackend().execute(signal + start, n, int(inv), step1, buffer);
+}
+
+template <typename T>
+FFT1D<T>::FFT1D(int n) {
     step = n;
-    transformed = 0;
 }
 
-void normalize(std::complex<float> f[], int n, float norm) {
+template <typename T>
+void normalize(std::complex<T> f[], int n, T norm) {
     for (int i = 0; i < n; i++) {
-        f[i].real(float(f[i].real() / norm));
-        f[i].imag(float(f[i].imag() / norm));
+        f[i].real(f[i].real() / norm);
+        f[i].imag(f[i].imag() / norm);
     }
 }
 
-Eigen::Matrix<std::complex<double>, 1, Dynamic> FFT1D::getMagnitude() {
-    if (transformed == 0) {
-        throw std::logic_error("perform transform first");
-    }
-    return mMagnitude;
+template <typename T>
+RealRow<T> FFT1D<T>::getMagnitude(const ComplexRow<T> &spectrum) {
+    return spectrum.cwiseAbs();
+}
+
+template <typename T>
+RealRow<T> FFT1D<T>::getPhase(const ComplexRow<T> &spectrum) {
+    return spectrum.unaryExpr([](const std::complex<T> &x) { return std::arg(x); });
 }
 
-Eigen::Matrix<std::complex<double>, 1, Dynamic> FFT1D::transform(const MatrixXi &item) {
+template <typename T>
+RealRow<T> FFT1D<T>::getLogMagnitude(const ComplexRow<T> &spectrum) {
+    return spectrum.unaryExpr([](const std::complex<T> &x) { return std::log1p(std::abs(x)); });
+}
+
+template <typename T>
+ComplexRow<T> FFT1D<T>::transform(const MatrixXi &item) const {
     int nrows = item.rows();
     int ncols = item.cols();
     int size = nrows * ncols;
 
-    /*convert image matrix to a complex array*/
-    std::complex<float> *spatial = new std::complex<float>[size];
-    std::complex<float> a;
+    /*convert image matrix to a complex array, transformed in place*/
+    ComplexRow<T> frequencyDomain(1, size);
+    std::complex<T> *spatial = frequencyDomain.data();
+    std::complex<T> a;
     for (int i = 0; i < nrows; ++i) {
         for (int j = 0; j < ncols; ++j) {
             a.real(item(i, j));
@@ -126,223 +546,1030 @@ Eigen::Matrix<std::complex<double>, 1, Dynamic> FFT1D::transform(const MatrixXi
             spatial[i * ncols + j] = a;
         }
     }
-    std::complex<float> *buffer = new std::complex<float>[size];
-    for (int i = 0; i < size; i++) {
-        buffer[i] = 0;
-    }
-    mainFFT1D(spatial, 0, size - 1, step, float(-1), buffer);
-    normalize(spatial, size, float(std::sqrt(size)));
-    delete[] buffer;
-
-    mfrequencyDomain.resize(1, size);
-    mMagnitude.resize(1, size);
+    std::complex<T> *buffer = TransformWorkspace::local().buffer<std::complex<T>>(GatherScratch, size);
+    fftBackend().execute(spatial, (size - 1) / step + 1, -1, step, buffer);
+    normalize(spatial, size, T(std::sqrt(size)));
 
-    for (int i = 0; i < size; i++) {
-        mfrequencyDomain[0, i] = spatial[i];
-    }
-    for (int i = 0; i < size; i++) {
-        mMagnitude[0, i] = std::abs(spatial[i]);
-    }
-    delete[] spatial;
-    transformed = 1;
-
-    return mfrequencyDomain;
+    return frequencyDomain;
 }
 
-Eigen::Matrix<int, 1, Dynamic> iFFT1D::transform(const Eigen::Matrix<std::complex<double>, 1, -1> &item) {
+template <typename T>
+Eigen::Matrix<int, 1, Dynamic> iFFT1D<T>::transform(const ComplexRow<T> &item) const {
     int nrows = item.rows();
     int ncols = item.cols();
     int size = nrows * ncols;
 
     /*convert image matrix to a complex array*/
-    std::complex<float> *frequency = new std::complex<float>[size];
+    std::complex<T> *frequency = TransformWorkspace::local().buffer<std::complex<T>>(SpectrumScratch, size);
     for (int i = 0; i < nrows; ++i) {
         for (int j = 0; j < ncols; ++j) {
-            frequency[i * ncols + j] = item[i, j];
+            frequency[i * ncols + j] = item(i, j);
         }
     }
-    std::complex<float> *buffer = new std::complex<float>[size];
+    fftBackend().execute(frequency, size, 1);
+    normalize(frequency, size, T(std::sqrt(size)));
+
+    Eigen::Matrix<int, 1, Dynamic> spatialDomain(1, size);
     for (int i = 0; i < size; i++) {
-        buffer[i] = 0;
+        spatialDomain(0, i) = round(frequency[i].real());
     }
-    mainFFT1D(frequency, 0, size - 1, 1, float(1), buffer);
-    normalize(frequency, size, float(std::sqrt(size)));
-    delete[] buffer;
+    return spatialDomain;
+}
 
-    mspatialDomain.resize(1, size);
-    for (int i = 0; i < size; i++) {
-        mspatialDomain[0, i] = round(frequency[i].real());
+/*number of rows gathered at once by the batched transforms*/
+static const int batchBlock = 16;
+
+template <typename T>
+BatchFFT1D<T>::BatchFFT1D(FFTAxis axis_) {
+    axis = axis_;
+}
+
+template <typename T>
+ComplexMatrix<T> BatchFFT1D<T>::transform(const MatrixXi &item) const {
+    ComplexMatrix<T> frequencyDomain;
+    transform(item, frequencyDomain, TransformWorkspace::local());
+    return frequencyDomain;
+}
+
+template <typename T>
+void BatchFFT1D<T>::transform(const MatrixXi &item, ComplexMatrix<T> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T>
+void BatchFFT1D<T>::transform(const MatrixXi &item, ComplexMatrix<T> &out, TransformWorkspace &workspace) const {
+    int nrows = item.rows();
+    int ncols = item.cols();
+    bool rows = (axis == FFTAxis::Rows);
+    int count = rows ? nrows : ncols;
+    int length = rows ? ncols : nrows;
+
+    const FFTBackend &backend = fftBackend();
+    T norm = T(std::sqrt(length));
+    out.resize(nrows, ncols);
+    ThreadPool &pool = ThreadPool::global();
+    workspace.prepareThreads(pool.size());
+
+    /*columns are contiguous in the column-major output and are transformed in place there.
+      Rows are strided: blocks of rows are gathered into the workspace of the thread and scattered
+      after the transform, so that every column-major access touches a run of consecutive rows*/
+    if (!rows) {
+        pool.parallelFor(0, count, [&](int begin, int end, int) {
+            for (int s = begin; s < end; ++s) {
+                std::complex<T> *signal = out.data() + size_t(s) * length;
+                for (int k = 0; k < length; ++k) {
+                    signal[k] = std::complex<T>(item(k, s), 0);
+                }
+                backend.execute(signal, length, -1);
+                normalize(signal, length, norm);
+            }
+        });
+    } else {
+        pool.parallelFor(0, (count + batchBlock - 1) / batchBlock, [&](int begin, int end, int thread) {
+            std::complex<T> *gathered =
+                workspace.thread(thread).buffer<std::complex<T>>(GatherScratch, size_t(batchBlock) * length);
+            for (int s0 = begin * batchBlock; s0 < std::min(end * batchBlock, count); s0 += batchBlock) {
+                int nb = std::min(batchBlock, count - s0);
+                for (int k = 0; k < length; ++k) {
+                    for (int b = 0; b < nb; ++b) {
+                        gathered[size_t(b) * length + k] = std::complex<T>(item(s0 + b, k), 0);
+                    }
+                }
+                for (int b = 0; b < nb; ++b) {
+                    backend.execute(gathered + size_t(b) * length, length, -1);
+                }
+                for (int k = 0; k < length; ++k) {
+                    for (int b = 0; b < nb; ++b) {
+                        out(s0 + b, k) = gathered[size_t(b) * length + k] / norm;
+                    }
+                }
+            }
+        });
     }
-    delete[] frequency;
-    transformed = 1;
-    std::cout << mspatialDomain;
-    return mspatialDomain;
 }
 
-FFT2D::FFT2D(int n) {
-    step = n;
-    transformed = 0;
+template <typename T>
+iBatchFFT1D<T>::iBatchFFT1D(FFTAxis axis_) {
+    axis = axis_;
+}
+
+template <typename T>
+Eigen::Matrix<int, -1, -1> iBatchFFT1D<T>::transform(const ComplexMatrix<T> &item) const {
+    Eigen::Matrix<int, -1, -1> spatialDomain;
+    transform(item, spatialDomain, TransformWorkspace::local());
+    return spatialDomain;
+}
+
+template <typename T>
+void iBatchFFT1D<T>::transform(const ComplexMatrix<T> &item, Eigen::Matrix<int, -1, -1> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T>
+void iBatchFFT1D<T>::transform(const ComplexMatrix<T> &item, Eigen::Matrix<int, -1, -1> &out,
+                               TransformWorkspace &workspace) const {
+    int nrows = item.rows();
+    int ncols = item.cols();
+    bool rows = (axis == FFTAxis::Rows);
+    int count = rows ? nrows : ncols;
+    int length = rows ? ncols : nrows;
+
+    const FFTBackend &backend = fftBackend();
+    T norm = T(std::sqrt(length));
+    out.resize(nrows, ncols);
+
+    /*blocks of signals are gathered into the workspace of the thread (see BatchFFT1D)*/
+    int block = rows ? batchBlock : 1;
+    ThreadPool &pool = ThreadPool::global();
+    workspace.prepareThreads(pool.size());
+    pool.parallelFor(0, (count + block - 1) / block, [&](int begin, int end, int thread) {
+        std::complex<T> *gathered = workspace.thread(thread).buffer<std::complex<T>>(GatherScratch, size_t(block) * length);
+        for (int s0 = begin * block; s0 < std::min(end * block, count); s0 += block) {
+            int nb = std::min(block, count - s0);
+            for (int k = 0; k < length; ++k) {
+                for (int b = 0; b < nb; ++b) {
+                    gathered[size_t(b) * length + k] = rows ? item(s0 + b, k) : item(k, s0 + b);
+                }
+            }
+            for (int b = 0; b < nb; ++b) {
+                backend.execute(gathered + size_t(b) * length, length, 1);
+            }
+            for (int k = 0; k < length; ++k) {
+                for (int b = 0; b < nb; ++b) {
+                    int value = round(gathered[size_t(b) * length + k].real() / norm);
+                    (rows ? out(s0 + b, k) : out(k, s0 + b)) = value;
+                }
+            }
+        }
+    });
 }
 
-Eigen::Matrix<std::complex<double>, -1, -1> FFT2D::getMagnitude() {
-    if (transformed == 0) {
-        throw std::logic_error("perform transform first");
+/*forward 2D transform (unnormalized) of an image into the column-major spectrum columns[width * nrows],
+  with width = cols/2+1 for a half spectrum*/
+template <typename T, typename P>
+static void forwardFFT2D(const PixelMatrix<P> &item, int step, bool halfSpectrum, std::complex<T> columns[],
+                         TransformWorkspace &workspace) {
+    int nrows = item.rows();
+    int ncols = item.cols();
+    int width = halfSpectrum ? ncols / 2 + 1 : ncols;
+
+    std::complex<T> *spectrum = workspace.buffer<std::complex<T>>(SpectrumScratch, size_t(nrows) * width);
+    ThreadPool &pool = ThreadPool::global();
+    workspace.prepareThreads(pool.size());
+    const FFTBackend &backend = fftBackend();
+
+    /*row pass: every thread converts and transforms a stripe of rows with its own scratch buffer*/
+    if (halfSpectrum) {
+        /*real rows: only the non-redundant half of every row spectrum is computed*/
+        pool.parallelFor(0, nrows, [&](int rowBegin, int rowEnd, int thread) {
+            T *row = workspace.thread(thread).buffer<T>(RowScratch, ncols);
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                for (int j = 0; j < ncols; ++j) {
+                    row[j] = item(i, j);
+                }
+                backend.r2c(row, spectrum + i * width, ncols);
+            }
+        });
+    } else {
+        /*the buffer is only used to gather strided signals*/
+        int rowLength = (ncols - 1) / step + 1;
+        pool.parallelFor(0, nrows, [&](int rowBegin, int rowEnd, int thread) {
+            std::complex<T> *buffer = workspace.thread(thread).buffer<std::complex<T>>(GatherScratch, ncols);
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                for (int j = 0; j < ncols; ++j) {
+                    spectrum[i * ncols + j] = std::complex<T>(item(i, j), 0);
+                }
+                backend.execute(spectrum + i * ncols, rowLength, -1, step, buffer);
+            }
+        });
     }
-    return mMagnitude;
+
+    /*column pass: every thread transposes a stripe of columns into contiguous rows and transforms them.
+      The transposed array is the column-major layout of the output matrix.*/
+    pool.parallelFor(0, width, [&](int colBegin, int colEnd, int) {
+        transposeBlocked(spectrum, columns, nrows, width, colBegin, colEnd);
+        for (int j = colBegin; j < colEnd; ++j) {
+            backend.execute(columns + j * nrows, nrows, -1);
+        }
+    });
 }
 
-Eigen::Matrix<std::complex<double>, -1, -1> FFT2D::transform(const MatrixXi &item) {
+/*inverse 2D transform of the column-major spectrum columns[width * nrows] (overwritten), divided by norm,
+  rounded and saturated to the pixel type. When weights (same layout) are given, every column is multiplied by its weights in place
+  right before its inverse transform, so that masking does not take a separate pass over the spectrum.*/
+template <typename T, typename P>
+static void inverseFFT2D(std::complex<T> columns[], int nrows, int ncols, bool halfSpectrum,
+                         const T weights[], T norm, PixelMatrix<P> &out, TransformWorkspace &workspace) {
+    int width = halfSpectrum ? ncols / 2 + 1 : ncols;
+    ThreadPool &pool = ThreadPool::global();
+    workspace.prepareThreads(pool.size());
+    const FFTBackend &backend = fftBackend();
+    pool.parallelFor(0, width, [&](int colBegin, int colEnd, int) {
+        for (int j = colBegin; j < colEnd; ++j) {
+            std::complex<T> *column = columns + j * nrows;
+            if (weights != nullptr) {
+                /*real weights times interleaved complex values, a plain loop the compiler vectorizes*/
+                T *values = reinterpret_cast<T *>(column);
+                const T *w = weights + j * nrows;
+                for (int i = 0; i < nrows; ++i) {
+                    values[2 * i] *= w[i];
+                    values[2 * i + 1] *= w[i];
+                }
+            }
+            backend.execute(column, nrows, 1);
+        }
+    });
+    std::complex<T> *frequency = workspace.buffer<std::complex<T>>(SpectrumScratch, size_t(nrows) * width);
+
+    /*every thread transposes a stripe of rows back before the row pass*/
+    out.resize(nrows, ncols);
+    if (halfSpectrum) {
+        /*Hermitian rows: the real row signals are rebuilt from their half spectra*/
+        pool.parallelFor(0, nrows, [&](int rowBegin, int rowEnd, int thread) {
+            T *row = workspace.thread(thread).buffer<T>(RowScratch, ncols);
+            transposeBlocked(columns, frequency, width, nrows, rowBegin, rowEnd);
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                backend.c2r(frequency + i * width, row, ncols);
+                for (int j = 0; j < ncols; ++j) {
+                    out(i, j) = saturatePixel<P>(row[j] / norm);
+                }
+            }
+        });
+    } else {
+        pool.parallelFor(0, nrows, [&](int rowBegin, int rowEnd, int) {
+            transposeBlocked(columns, frequency, width, nrows, rowBegin, rowEnd);
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                backend.execute(frequency + i * ncols, ncols, 1);
+                for (int j = 0; j < ncols; ++j) {
+                    out(i, j) = saturatePixel<P>(frequency[i * ncols + j].real() / norm);
+                }
+            }
+        });
+    }
+}
+
+template <typename T>
+FFT2D<T>::FFT2D(int n, bool halfSpectrum_) {
+    step = n;
+    halfSpectrum = halfSpectrum_;
+
+    if (halfSpectrum && step != 1) {
+        throw std::invalid_argument("Half-spectrum FFT2D only supports step 1");
+    }
+}
+
+template <typename T>
+RealMatrix<T> FFT2D<T>::getMagnitude(const ComplexMatrix<T> &spectrum) {
+    return spectrum.cwiseAbs();
+}
+
+template <typename T>
+RealMatrix<T> FFT2D<T>::getPhase(const ComplexMatrix<T> &spectrum) {
+    return spectrum.unaryExpr([](const std::complex<T> &x) { return std::arg(x); });
+}
+
+template <typename T>
+RealMatrix<T> FFT2D<T>::getLogMagnitude(const ComplexMatrix<T> &spectrum) {
+    return spectrum.unaryExpr([](const std::complex<T> &x) { return std::log1p(std::abs(x)); });
+}
+
+template <typename T>
+ComplexMatrix<T> FFT2D<T>::transform(const MatrixXi &item) const {
+    ComplexMatrix<T> frequencyDomain;
+    transform(item, frequencyDomain, TransformWorkspace::local());
+    return frequencyDomain;
+}
+
+template <typename T>
+void FFT2D<T>::transform(const MatrixXi &item, ComplexMatrix<T> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T>
+void FFT2D<T>::transform(const MatrixXi &item, ComplexMatrix<T> &out, TransformWorkspace &workspace) const {
     int nrows = item.rows();
     int ncols = item.cols();
     int size = nrows * ncols;
+    int width = halfSpectrum ? ncols / 2 + 1 : ncols;
 
-    std::complex<float> *spatial = new std::complex<float>[size];
-    std::complex<float> a;
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            a.real(item(i, j));
-            a.imag(0);
-            spatial[i * ncols + j] = a;
-        }
+    /*the transposed output of the column pass is the column-major layout of the spectrum*/
+    out.resize(nrows, width);
+    forwardFFT2D(item, step, halfSpectrum, out.data(), workspace);
+    normalize(out.data(), nrows * width, T(std::sqrt(size)));
+}
+
+template <typename T>
+iFFT2D<T>::iFFT2D(int fullCols_) {
+    fullCols = fullCols_;
+}
+
+template <typename T>
+Eigen::Matrix<int, -1, -1> iFFT2D<T>::transform(const ComplexMatrix<T> &item) const {
+    Eigen::Matrix<int, -1, -1> spatialDomain;
+    transform(item, spatialDomain, TransformWorkspace::local());
+    return spatialDomain;
+}
+
+template <typename T>
+void iFFT2D<T>::transform(const ComplexMatrix<T> &item, Eigen::Matrix<int, -1, -1> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T>
+void iFFT2D<T>::transform(const ComplexMatrix<T> &item, Eigen::Matrix<int, -1, -1> &out,
+                          TransformWorkspace &workspace) const {
+    int nrows = item.rows();
+    int width = item.cols();
+    bool halfSpectrum = fullCols > 0;
+    int ncols = halfSpectrum ? fullCols : width;
+    int size = nrows * ncols;
+
+    if (halfSpectrum && width != ncols / 2 + 1) {
+        throw std::invalid_argument(
+            "Half spectrum of " + std::to_string(ncols) + " columns must have " +
+            std::to_string(ncols / 2 + 1) + " columns, got " + std::to_string(width));
     }
-    std::complex<float> *buffer;
-    for (int i = 0; i < nrows; ++i) {
-        buffer = new std::complex<float>[ncols];
-        mainFFT1D(spatial, i * ncols, (i + 1) * ncols - 1, step, -1, buffer);
-        delete[] buffer;
+
+    /*the column-major input is the transposed array: columns are transformed as contiguous rows*/
+    std::complex<T> *columns = workspace.buffer<std::complex<T>>(ColumnsScratch, size_t(width) * nrows);
+    for (int k = 0; k < width * nrows; ++k) {
+        columns[k] = item.data()[k];
+    }
+    inverseFFT2D(columns, nrows, ncols, halfSpectrum, (const T *) nullptr, T(std::sqrt(size)), out, workspace);
+}
+
+// Frequency-domain filters
+
+void FilterSpec::validate() const {
+    bool ideal = (type == IdealLowpass || type == IdealHighpass);
+    if (!ideal && !(cutoff > 0)) {
+        throw std::invalid_argument("Cutoff of a smooth filter must be positive, got " + std::to_string(cutoff));
+    }
+    if (order < 1) {
+        throw std::invalid_argument("Filter order must be positive, got " + std::to_string(order));
     }
-    for (int j = 0; j < ncols; ++j) {
-        buffer = new std::complex<float>[nrows];
-        mainFFT1D(spatial, j, ncols * (nrows - 1) + j, ncols, -1, buffer);
-        delete[] buffer;
+    if (type == Bandpass && !(cutoff2 > cutoff)) {
+        throw std::invalid_argument("Upper cutoff of a band-pass must be above its lower cutoff");
     }
-    normalize(spatial, size, float(std::sqrt(size)));
+}
 
-    mfrequencyDomain.resize(nrows, ncols);
-    mMagnitude.resize(nrows, ncols);
+bool FilterSpec::operator<(const FilterSpec &other) const {
+    return std::tie(type, cutoff, cutoff2, order, notchRow, notchCol) <
+           std::tie(other.type, other.cutoff, other.cutoff2, other.order, other.notchRow, other.notchCol);
+}
 
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            mfrequencyDomain(i, j) = spatial[i * ncols + j];
+/*Butterworth lowpass 1 / (1 + (D / c)^(2n)) from the squared distance and cutoff*/
+static double butterworthLowpass(double d2, double c2, int order) {
+    return 1. / (1. + std::pow(d2 / c2, order));
+}
+
+/*Butterworth highpass 1 / (1 + (c / D)^(2n)), 0 at DC*/
+static double butterworthHighpass(double d2, double c2, int order) {
+    return (d2 == 0) ? 0. : 1. / (1. + std::pow(c2 / d2, order));
+}
+
+/*signed frequency of index a of an unshifted spectrum of size n (DC at 0, in (-n/2, n/2])*/
+static int wrappedFrequency(int a, int n) {
+    a %= n;
+    if (a < 0) {
+        a += n;
+    }
+    return (a > n / 2) ? a - n : a;
+}
+
+/*weight of a filter at frequency (a, b) of the full spectrum*/
+static double filterWeight(const FilterSpec &spec, int a, int b, int nrows, int ncols) {
+    double c2 = spec.cutoff * spec.cutoff;
+    if (spec.type == FilterSpec::IdealLowpass || spec.type == FilterSpec::IdealHighpass) {
+        /*the ideal filters keep the convention of LowpassFilter and HighpassFilter: distance to (nrows/2, ncols/2)*/
+        double du = a - nrows / 2;
+        double dv = b - ncols / 2;
+        bool inside = spec.cutoff >= 0 && du * du + dv * dv <= c2;
+        return (inside == (spec.type == FilterSpec::IdealLowpass)) ? 1. : 0.;
+    }
+
+    /*squared distances to DC are compared with squared cutoffs (no square root per coefficient)*/
+    double du = wrappedFrequency(a, nrows);
+    double dv = wrappedFrequency(b, ncols);
+    double d2 = du * du + dv * dv;
+    switch (spec.type) {
+        case FilterSpec::GaussianLowpass:
+            return std::exp(-d2 / (2 * c2));
+        case FilterSpec::GaussianHighpass:
+            return 1. - std::exp(-d2 / (2 * c2));
+        case FilterSpec::ButterworthLowpass:
+            return butterworthLowpass(d2, c2, spec.order);
+        case FilterSpec::ButterworthHighpass:
+            return butterworthHighpass(d2, c2, spec.order);
+        case FilterSpec::Bandpass:
+            return butterworthHighpass(d2, c2, spec.order) *
+                   butterworthLowpass(d2, spec.cutoff2 * spec.cutoff2, spec.order);
+        case FilterSpec::Notch: {
+            double pu = wrappedFrequency(a - spec.notchRow, nrows);
+            double pv = wrappedFrequency(b - spec.notchCol, ncols);
+            double mu = wrappedFrequency(a + spec.notchRow, nrows);
+            double mv = wrappedFrequency(b + spec.notchCol, ncols);
+            return butterworthHighpass(pu * pu + pv * pv, c2, spec.order) *
+                   butterworthHighpass(mu * mu + mv * mv, c2, spec.order);
         }
+        default:
+            return 0.;
     }
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            mMagnitude(i, j) = std::abs(spatial[i * ncols + j]);
+}
+
+template <typename T>
+FrequencyMask<T>::FrequencyMask(const FilterSpec &spec, int nrows_, int ncols, bool halfSpectrum) {
+    nrows = nrows_;
+    width = halfSpectrum ? ncols / 2 + 1 : ncols;
+    weights.resize(size_t(nrows) * width);
+    for (int j = 0; j < width; ++j) {
+        for (int i = 0; i < nrows; ++i) {
+            double w = filterWeight(spec, i, j, nrows, ncols);
+            if (halfSpectrum) {
+                w = 0.5 * (w + filterWeight(spec, (nrows - i) % nrows, (ncols - j) % ncols, nrows, ncols));
+            }
+            weights[size_t(j) * nrows + i] = T(w);
+        }
+    }
+}
+
+template <typename T>
+std::shared_ptr<const FrequencyMask<T>> FrequencyMask<T>::get(const FilterSpec &spec, int nrows, int ncols,
+                                                              bool halfSpectrum) {
+    typedef std::tuple<int, int, bool, FilterSpec> Key;
+    static std::map<Key, std::shared_ptr<const FrequencyMask<T>>> cache;
+    static std::mutex cache_mutex;
+
+    Key key(nrows, ncols, halfSpectrum, spec);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto found = cache.find(key);
+        if (found != cache.end()) {
+            return found->second;
         }
     }
+    auto mask = std::make_shared<const FrequencyMask<T>>(spec, nrows, ncols, halfSpectrum);
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache.emplace(key, mask).first->second;
+}
+
+template <typename T>
+const T *FrequencyMask<T>::data() const {
+    return weights.data();
+}
+
+template <typename T>
+int FrequencyMask<T>::rows() const {
+    return nrows;
+}
 
-    delete[] spatial;
-    transformed = 1;
+template <typename T>
+int FrequencyMask<T>::cols() const {
+    return width;
+}
 
-    return mfrequencyDomain;
+template <typename T>
+T FrequencyMask<T>::operator()(int i, int j) const {
+    return weights[size_t(j) * nrows + i];
 }
 
-Eigen::Matrix<int, -1, -1> iFFT2D::transform(const Eigen::Matrix<std::complex<double>, -1, -1> &item) {
+/*forward FFT2D, cached mask applied in the first inverse pass, inverse FFT2D*/
+template <typename T, typename P>
+static void filterImage(const PixelMatrix<P> &item, int step, const FilterSpec &spec, PixelMatrix<P> &filtered,
+                        TransformWorkspace &workspace) {
     int nrows = item.rows();
     int ncols = item.cols();
-    int size = nrows * ncols;
+    bool halfSpectrum = (step == 1);
+    int width = halfSpectrum ? ncols / 2 + 1 : ncols;
 
-    /*convert image matrix to a complex array*/
-    std::complex<float> *frequency = new std::complex<float>[size];
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            frequency[i * ncols + j] = item(i, j);
+    /*only the non-redundant half spectrum is needed for real input*/
+    std::complex<T> *columns = workspace.buffer<std::complex<T>>(ColumnsScratch, size_t(width) * nrows);
+    forwardFFT2D(item, step, halfSpectrum, columns, workspace);
+    auto mask = FrequencyMask<T>::get(spec, nrows, ncols, halfSpectrum);
+
+    /*both normalizations by sqrt(size) are applied at once*/
+    inverseFFT2D(columns, nrows, ncols, halfSpectrum, mask->data(), T(nrows) * T(ncols), filtered, workspace);
+}
+
+template <typename T, typename P>
+FrequencyFilter<T, P>::FrequencyFilter(const FilterSpec &spec_) {
+    spec = spec_;
+    spec.validate();
+}
+
+template <typename T, typename P>
+PixelMatrix<P> FrequencyFilter<T, P>::transform(const PixelMatrix<P> &item) const {
+    PixelMatrix<P> filtered;
+    transform(item, filtered, TransformWorkspace::local());
+    return filtered;
+}
+
+template <typename T, typename P>
+void FrequencyFilter<T, P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T, typename P>
+void FrequencyFilter<T, P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &out, TransformWorkspace &workspace) const {
+    filterImage<T>(item, 1, spec, out, workspace);
+}
+
+template <typename T, typename P>
+FilterBank<T, P>::FilterBank(const std::vector<FilterSpec> &specs_) {
+    specs = specs_;
+    for (const auto &spec : specs) {
+        spec.validate();
+    }
+}
+
+template <typename T, typename P>
+std::vector<PixelMatrix<P>> FilterBank<T, P>::transform(const PixelMatrix<P> &item) const {
+    std::vector<PixelMatrix<P>> filtered;
+    transform(item, filtered, TransformWorkspace::local());
+    return filtered;
+}
+
+template <typename T, typename P>
+void FilterBank<T, P>::transform(const PixelMatrix<P> &item, std::vector<PixelMatrix<P>> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T, typename P>
+void FilterBank<T, P>::transform(const PixelMatrix<P> &item, std::vector<PixelMatrix<P>> &out, TransformWorkspace &workspace) const {
+    int nrows = item.rows();
+    int ncols = item.cols();
+    int width = ncols / 2 + 1;
+    size_t size = size_t(width) * nrows;
+    int count = specs.size();
+
+    std::complex<T> *spectrum = workspace.buffer<std::complex<T>>(ColumnsScratch, size);
+    forwardFFT2D(item, 1, true, spectrum, workspace);
+
+    /*the inverse transforms of the filters are split between the threads (their own loops then run serially),
+      unless there are fewer filters than threads. Every thread masks and transforms a copy of the spectrum
+      in its own workspace.*/
+    out.resize(count);
+    ThreadPool &pool = ThreadPool::global();
+    workspace.prepareThreads(pool.size());
+    auto inverse = [&](int begin, int end, int thread) {
+        TransformWorkspace &local = workspace.thread(thread);
+        std::complex<T> *columns = local.buffer<std::complex<T>>(CopyScratch, size);
+        for (int f = begin; f < end; ++f) {
+            auto mask = FrequencyMask<T>::get(specs[f], nrows, ncols, true);
+            std::copy(spectrum, spectrum + size, columns);
+            inverseFFT2D(columns, nrows, ncols, true, mask->data(), T(nrows) * T(ncols), out[f], local);
         }
+    };
+    if (count >= pool.size()) {
+        pool.parallelFor(0, count, inverse);
+    } else {
+        inverse(0, count, 0);
     }
+}
 
-    std::complex<float> *buffer;
-    for (int i = 0; i < nrows; ++i) {
-        buffer = new std::complex<float>[ncols];
-        mainFFT1D(frequency, i * ncols, (i + 1) * ncols - 1, 1, 1, buffer);
-        delete[] buffer;
+/*L2 budget of the buffers of a convolution tile: real tile, row spectra and column spectra*/
+static const size_t convolutionTileBytes = size_t(1) << 19;
+
+/*forward transform of a real tile (rows x cols, row-major) into its column-major half spectrum (width x rows)*/
+template <typename T>
+static void forwardTile(const FFTBackend &backend, const T tile[], std::complex<T> rowSpectra[],
+                        std::complex<T> columns[], int rows, int cols) {
+    int width = cols / 2 + 1;
+    for (int i = 0; i < rows; ++i) {
+        backend.r2c(tile + i * cols, rowSpectra + i * width, cols);
     }
-    for (int j = 0; j < ncols; ++j) {
-        buffer = new std::complex<float>[nrows];
-        mainFFT1D(frequency, j, ncols * (nrows - 1) + j, ncols, 1, buffer);
-        delete[] buffer;
+    transposeBlocked(rowSpectra, columns, rows, width, 0, width);
+    for (int j = 0; j < width; ++j) {
+        backend.execute(columns + j * rows, rows, -1);
     }
-    normalize(frequency, size, float(std::sqrt(size)));
-    mspatialDomain.resize(nrows, ncols);
-    for (int i = 0; i < nrows; ++i) {
-        for (int j = 0; j < ncols; ++j) {
-            mspatialDomain(i, j) = round(frequency[i * ncols + j].real());
+}
+
+/*inverse of forwardTile (unnormalized), the column spectra are overwritten*/
+template <typename T>
+static void inverseTile(const FFTBackend &backend, std::complex<T> columns[], std::complex<T> rowSpectra[],
+                        T tile[], int rows, int cols) {
+    int width = cols / 2 + 1;
+    for (int j = 0; j < width; ++j) {
+        backend.execute(columns + j * rows, rows, 1);
+    }
+    transposeBlocked(columns, rowSpectra, width, rows, 0, rows);
+    for (int i = 0; i < rows; ++i) {
+        backend.c2r(rowSpectra + i * width, tile + i * cols, cols);
+    }
+}
+
+/*x *= y for interleaved complex arrays, written out so that the compiler vectorizes it
+  (std::complex multiplication checks for infinities and calls a library function)*/
+template <typename T>
+static void multiplySpectra(std::complex<T> x[], const std::complex<T> y[], size_t n) {
+    T *a = reinterpret_cast<T *>(x);
+    const T *b = reinterpret_cast<const T *>(y);
+    for (size_t k = 0; k < n; ++k) {
+        T re = a[2 * k] * b[2 * k] - a[2 * k + 1] * b[2 * k + 1];
+        T im = a[2 * k] * b[2 * k + 1] + a[2 * k + 1] * b[2 * k];
+        a[2 * k] = re;
+        a[2 * k + 1] = im;
+    }
+}
+
+template <typename T>
+FFTConvolution<T>::FFTConvolution(const MatrixXd &kernel_, int tileSize_) {
+    if (kernel_.size() == 0) {
+        throw std::invalid_argument("Convolution kernel is empty");
+    }
+    if (tileSize_ < 0 || (tileSize_ > 0 && (tileSize_ < kernel_.rows() || tileSize_ < kernel_.cols()))) {
+        throw std::invalid_argument("Convolution tiles must be at least as large as the kernel, got " +
+                                    std::to_string(tileSize_));
+    }
+    kernel = kernel_;
+    tileSize = tileSize_;
+}
+
+template <typename T>
+void FFTConvolution<T>::tileShape(int nrows, int ncols, int &tileRows, int &tileCols) const {
+    if (tileSize > 0) {
+        tileRows = tileSize;
+        tileCols = tileSize;
+        return;
+    }
+    auto powerOfTwo = [](int n) {
+        int m = 1;
+        while (m < n) {
+            m *= 2;
+        }
+        return m;
+    };
+    auto bytes = [](int rows, int cols) {
+        return size_t(rows) * cols * sizeof(T) + 2 * size_t(rows) * (cols / 2 + 1) * sizeof(std::complex<T>);
+    };
+    /*at least half of every tile is output, the tiles then grow while they fit in the budget,
+      but not beyond a single tile covering the whole image*/
+    int kr = kernel.rows();
+    int kc = kernel.cols();
+    int maxRows = powerOfTwo(nrows + kr - 1);
+    int maxCols = powerOfTwo(ncols + kc - 1);
+    tileRows = std::max(std::min(powerOfTwo(2 * kr), maxRows), kr);
+    tileCols = std::max(std::min(powerOfTwo(2 * kc), maxCols), kc);
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        if (tileRows < maxRows && bytes(2 * tileRows, tileCols) <= convolutionTileBytes) {
+            tileRows *= 2;
+            grown = true;
+        }
+        if (tileCols < maxCols && bytes(tileRows, 2 * tileCols) <= convolutionTileBytes) {
+            tileCols *= 2;
+            grown = true;
+        }
+    }
+}
+
+/*the spectrum of the kernel is kept for the next images with the same tile shape, the
+  normalization of the inverse transform is folded into it*/
+template <typename T>
+std::shared_ptr<const std::vector<std::complex<T>>> FFTConvolution<T>::kernelSpectrum(int tileRows, int tileCols) const {
+    std::pair<int, int> key(tileRows, tileCols);
+    {
+        std::lock_guard<std::mutex> lock(spectraMutex);
+        auto found = kernelSpectra.find(key);
+        if (found != kernelSpectra.end()) {
+            return found->second;
+        }
+    }
+    size_t tileSpectrum = size_t(tileCols / 2 + 1) * tileRows;
+    std::vector<T> tile(size_t(tileRows) * tileCols, T(0));
+    std::vector<std::complex<T>> rowSpectra(tileSpectrum);
+    auto spectrum = std::make_shared<std::vector<std::complex<T>>>(tileSpectrum);
+    for (int a = 0; a < kernel.rows(); ++a) {
+        for (int b = 0; b < kernel.cols(); ++b) {
+            tile[a * tileCols + b] = kernel(a, b) / (T(tileRows) * T(tileCols));
         }
     }
-    delete[] frequency;
-    transformed = 1;
+    forwardTile(fftBackend(), tile.data(), rowSpectra.data(), spectrum->data(), tileRows, tileCols);
+    std::lock_guard<std::mutex> lock(spectraMutex);
+    return kernelSpectra.emplace(key, spectrum).first->second;
+}
 
-    return mspatialDomain;
+template <typename T>
+MatrixXd FFTConvolution<T>::transform(const MatrixXi &item) const {
+    MatrixXd convolved;
+    transform(item, convolved, TransformWorkspace::local());
+    return convolved;
 }
 
-LowpassFilter::LowpassFilter(const double threshold, int step) {
-    thr = threshold;
-    stp = step;
-    transformed = 0;
+template <typename T>
+void FFTConvolution<T>::transform(const MatrixXi &item, MatrixXd &out) const {
+    transform(item, out, TransformWorkspace::local());
 }
 
-MatrixXi LowpassFilter::transform(const MatrixXi &item) {
+template <typename T>
+void FFTConvolution<T>::transform(const MatrixXi &item, MatrixXd &out, TransformWorkspace &workspace) const {
     int nrows = item.rows();
     int ncols = item.cols();
-    int size = nrows * ncols;
-    int rowc = nrows / 2;
-    int colc = ncols / 2;
-
-    /*perform 2DFFT*/
-    FFT2D a(stp);
-    Eigen::Matrix<std::complex<double>, -1, -1> copyfrequency;
-    copyfrequency.resize(nrows, ncols);
-    copyfrequency = a.transform(item);
-
-    for (int i = 0; i < nrows; i++) {
-        for (int j = 0; j < ncols; j++) {
-            if (double(std::sqrt((i - rowc) * (i - rowc) +
-                                 (j - colc) * (j - colc))) > thr) {
-                copyfrequency(i, j) = std::complex<double>(0.0, 0.0);
-            } else {
-                continue;
+    if (item.size() == 0) {
+        out.resize(nrows, ncols);
+        return;
+    }
+    int kr = kernel.rows();
+    int kc = kernel.cols();
+    int tileRows, tileCols;
+    tileShape(nrows, ncols, tileRows, tileCols);
+    int width = tileCols / 2 + 1;
+    size_t tileSpectrum = size_t(width) * tileRows;
+    const FFTBackend &backend = fftBackend();
+    auto kernelColumns = kernelSpectrum(tileRows, tileCols);
+
+    /*overlap-save: tile row p holds image row r0 + p - (kr - 1) + kr/2, its rows p >= kr - 1 are not wrapped around*/
+    int blockRows = tileRows - kr + 1;
+    int blockCols = tileCols - kc + 1;
+    int gridRows = (nrows + blockRows - 1) / blockRows;
+    int gridCols = (ncols + blockCols - 1) / blockCols;
+    out.resize(nrows, ncols);
+    ThreadPool &pool = ThreadPool::global();
+    workspace.prepareThreads(pool.size());
+    pool.parallelFor(0, gridRows * gridCols, [&](int begin, int end, int thread) {
+        TransformWorkspace &local = workspace.thread(thread);
+        T *tile = local.buffer<T>(TileScratch, size_t(tileRows) * tileCols);
+        std::complex<T> *rowSpectra = local.buffer<std::complex<T>>(TileRowsScratch, tileSpectrum);
+        std::complex<T> *columns = local.buffer<std::complex<T>>(TileColumnsScratch, tileSpectrum);
+        for (int t = begin; t < end; ++t) {
+            int r0 = (t / gridCols) * blockRows;
+            int c0 = (t % gridCols) * blockCols;
+            int sr = r0 + kr / 2 - (kr - 1);
+            int sc = c0 + kc / 2 - (kc - 1);
+            for (int p = 0; p < tileRows; ++p) {
+                int i = sr + p;
+                for (int q = 0; q < tileCols; ++q) {
+                    int j = sc + q;
+                    bool inside = i >= 0 && i < nrows && j >= 0 && j < ncols;
+                    tile[p * tileCols + q] = inside ? T(item(i, j)) : T(0);
+                }
+            }
+            forwardTile(backend, tile, rowSpectra, columns, tileRows, tileCols);
+            multiplySpectra(columns, kernelColumns->data(), tileSpectrum);
+            inverseTile(backend, columns, rowSpectra, tile, tileRows, tileCols);
+
+            int rows = std::min(blockRows, nrows - r0);
+            int cols = std::min(blockCols, ncols - c0);
+            for (int q = 0; q < cols; ++q) {
+                for (int p = 0; p < rows; ++p) {
+                    out(r0 + p, c0 + q) = tile[(p + kr - 1) * tileCols + q + kc - 1];
+                }
             }
         }
+    });
+}
+
+/*out (rows x cols) = in (rows + kr - 1 x cols + kc - 1, zero-padded) convolved with w (kr x kc), column-major arrays.
+  Every output column is a sum of kr * kc scaled input columns: contiguous loops that the compiler vectorizes.*/
+template <typename T>
+static void convolveColumns(const T in[], T out[], int rows, int cols, const T w[], int kr, int kc) {
+    size_t inRows = rows + kr - 1;
+    ThreadPool::global().parallelFor(0, cols, [&](int begin, int end, int) {
+        for (int j = begin; j < end; ++j) {
+            T *acc = out + size_t(j) * rows;
+            std::fill(acc, acc + rows, T(0));
+            for (int b = 0; b < kc; ++b) {
+                /*the taps of a kernel column read the same input column shifted by one row, four of them
+                  are added per pass over the accumulator*/
+                const T *src = in + (j + kc - 1 - b) * inRows + (kr - 1);
+                const T *wb = w + b * kr;
+                int a = 0;
+                for (; a + 4 <= kr; a += 4) {
+                    T w0 = wb[a], w1 = wb[a + 1], w2 = wb[a + 2], w3 = wb[a + 3];
+                    const T *s = src - a;
+                    for (int i = 0; i < rows; ++i) {
+                        acc[i] += w0 * s[i] + w1 * s[i - 1] + w2 * s[i - 2] + w3 * s[i - 3];
+                    }
+                }
+                for (; a < kr; ++a) {
+                    T weight = wb[a];
+                    const T *s = src - a;
+                    for (int i = 0; i < rows; ++i) {
+                        acc[i] += weight * s[i];
+                    }
+                }
+            }
+        }
+    });
+}
+
+/*cost model of the convolutions, in multiply-adds of the direct convolution (fitted on bench convmethods):
+  padding and conversion of every pixel, the slower single-tap passes of the separable convolution,
+  and the forward and inverse real 2d FFTs and the products of the spectra of a tiled FFT convolution*/
+static const double convolutionPixelCost = 16;
+static const double separableTapCost = 1.4;
+static const double fftTileCost = 4;
+
+template <typename T>
+Convolution<T>::Convolution(const MatrixXd &kernel_, ConvolutionMethod method_) : fft(kernel_) {
+    kernelRows = kernel_.rows();
+    kernelCols = kernel_.cols();
+    weights.assign(kernel_.data(), kernel_.data() + kernel_.size());
+    method = method_;
+
+    /*rank one up to rounding: the kernel is rebuilt from the first singular vectors*/
+    Eigen::JacobiSVD<MatrixXd> svd(kernel_, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    Eigen::VectorXd u = svd.matrixU().col(0) * svd.singularValues()(0);
+    Eigen::VectorXd v = svd.matrixV().col(0);
+    double error = (kernel_ - u * v.transpose()).cwiseAbs().maxCoeff();
+    separable = error <= 1e-12 * kernel_.cwiseAbs().maxCoeff();
+    if (separable) {
+        columnFactor.assign(u.data(), u.data() + u.size());
+        rowFactor.assign(v.data(), v.data() + v.size());
+    } else if (method == ConvolutionMethod::Separable) {
+        throw std::invalid_argument("Convolution kernel is not separable");
     }
-    iFFT2D b;
-    filtered.resize(nrows, ncols);
-    filtered = b.transform(copyfrequency);
-    transformed = 1;
-    return filtered;
 }
 
-HighpassFilter::HighpassFilter(const double threshold, int step) {
-    thr = threshold;
-    stp = step;
-    transformed = 0;
+template <typename T>
+bool Convolution<T>::isSeparable() const {
+    return separable;
+}
+
+template <typename T>
+ConvolutionMethod Convolution<T>::choose(int nrows, int ncols) const {
+    if (method != ConvolutionMethod::Auto) {
+        return method;
+    }
+    int kr = kernelRows;
+    int kc = kernelCols;
+    double pixels = double(nrows) * ncols;
+    double direct = pixels * (kr * kc + convolutionPixelCost);
+    double separated = separable ?
+        separableTapCost * (double(nrows) * (ncols + kc - 1) * kr + pixels * kc) + pixels * convolutionPixelCost : direct;
+
+    int tileRows, tileCols;
+    fft.tileShape(nrows, ncols, tileRows, tileCols);
+    double tiles = double((nrows + tileRows - kr) / (tileRows - kr + 1)) * ((ncols + tileCols - kc) / (tileCols - kc + 1));
+    double tileSize = double(tileRows) * tileCols;
+    double fourier = fftTileCost * tiles * tileSize * std::log2(tileSize);
+
+    if (fourier < std::min(direct, separated)) {
+        return ConvolutionMethod::FFT;
+    }
+    return (separated < direct) ? ConvolutionMethod::Separable : ConvolutionMethod::Direct;
+}
+
+template <typename T>
+MatrixXd Convolution<T>::transform(const MatrixXi &item) const {
+    MatrixXd convolved;
+    transform(item, convolved, TransformWorkspace::local());
+    return convolved;
+}
+
+template <typename T>
+void Convolution<T>::transform(const MatrixXi &item, MatrixXd &out) const {
+    transform(item, out, TransformWorkspace::local());
 }
 
-MatrixXi HighpassFilter::transform(const MatrixXi &item) {
+template <typename T>
+void Convolution<T>::transform(const MatrixXi &item, MatrixXd &out, TransformWorkspace &workspace) const {
     int nrows = item.rows();
     int ncols = item.cols();
-    int size = nrows * ncols;
-    int rowc = nrows / 2;
-    int colc = ncols / 2;
-
-    /*perform 2DFFT*/
-    FFT2D a(stp);
-    Eigen::Matrix<std::complex<double>, -1, -1> copyfrequency;
-    copyfrequency.resize(nrows, ncols);
-    copyfrequency = a.transform(item);
-
-    for (int i = 0; i < nrows; i++) {
-        for (int j = 0; j < ncols; j++) {
-            if (double(std::sqrt((i - rowc) * (i - rowc) +
-                                 (j - colc) * (j - colc))) <= thr) {
-                copyfrequency(i, j) = std::complex<double>(0.0, 0.0);
-            } else {
-                continue;
-            }
+    if (item.size() == 0) {
+        out.resize(nrows, ncols);
+        return;
+    }
+    ConvolutionMethod chosen = choose(nrows, ncols);
+    if (chosen == ConvolutionMethod::FFT) {
+        fft.transform(item, out, workspace);
+        return;
+    }
+
+    /*item(x, y) is at (x + kr - 1 - kr/2, y + kc - 1 - kc/2) of the zero-padded image*/
+    int kr = kernelRows;
+    int kc = kernelCols;
+    int paddedRows = nrows + kr - 1;
+    int paddedCols = ncols + kc - 1;
+    int top = kr - 1 - kr / 2;
+    int left = kc - 1 - kc / 2;
+    T *padded = workspace.buffer<T>(PaddedScratch, size_t(paddedRows) * paddedCols);
+    std::fill(padded, padded + size_t(paddedRows) * paddedCols, T(0));
+    for (int y = 0; y < ncols; ++y) {
+        T *column = padded + size_t(y + left) * paddedRows + top;
+        for (int x = 0; x < nrows; ++x) {
+            column[x] = item(x, y);
         }
     }
-    iFFT2D b;
-    filtered.resize(nrows, ncols);
-    filtered = b.transform(copyfrequency);
-    transformed = 1;
+
+    T *result = workspace.buffer<T>(OutputScratch, size_t(nrows) * ncols);
+    if (chosen == ConvolutionMethod::Separable) {
+        /*column pass on all the padded columns, then row pass*/
+        T *columnPass = workspace.buffer<T>(PassScratch, size_t(nrows) * paddedCols);
+        convolveColumns(padded, columnPass, nrows, paddedCols, columnFactor.data(), kr, 1);
+        convolveColumns(columnPass, result, nrows, ncols, rowFactor.data(), 1, kc);
+    } else {
+        convolveColumns(padded, result, nrows, ncols, weights.data(), kr, kc);
+    }
+    out = Eigen::Map<Eigen::Matrix<T, Dynamic, Dynamic>>(result, nrows, ncols).template cast<double>();
+}
+
+template <typename T, typename P>
+LowpassFilter<T, P>::LowpassFilter(const double threshold, int step) {
+    thr = threshold;
+    stp = step;
+}
+
+template <typename T, typename P>
+PixelMatrix<P> LowpassFilter<T, P>::transform(const PixelMatrix<P> &item) const {
+    PixelMatrix<P> filtered;
+    transform(item, filtered, TransformWorkspace::local());
+    return filtered;
+}
+
+template <typename T, typename P>
+void LowpassFilter<T, P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T, typename P>
+void LowpassFilter<T, P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &out, TransformWorkspace &workspace) const {
+    filterImage<T>(item, stp, FilterSpec{FilterSpec::IdealLowpass, thr}, out, workspace);
+}
+
+template <typename T, typename P>
+HighpassFilter<T, P>::HighpassFilter(const double threshold, int step) {
+    thr = threshold;
+    stp = step;
+}
+
+template <typename T, typename P>
+PixelMatrix<P> HighpassFilter<T, P>::transform(const PixelMatrix<P> &item) const {
+    PixelMatrix<P> filtered;
+    transform(item, filtered, TransformWorkspace::local());
     return filtered;
-}
\ No newline at end of file
+}
+
+template <typename T, typename P>
+void HighpassFilter<T, P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &out) const {
+    transform(item, out, TransformWorkspace::local());
+}
+
+template <typename T, typename P>
+void HighpassFilter<T, P>::transform(const PixelMatrix<P> &item, PixelMatrix<P> &out, TransformWorkspace &workspace) const {
+    filterImage<T>(item, stp, FilterSpec{FilterSpec::IdealHighpass, thr}, out, workspace);
+}
+
+/*the pointwise transforms are compiled for int, 8-bit and 16-bit pixels*/
+template class Thresholding<int>;
+template class Thresholding<uint8_t>;
+template class Thresholding<uint16_t>;
+template class Histogram<int>;
+template class Histogram<uint8_t>;
+template class Histogram<uint16_t>;
+template class BinnedHistogram<double>;
+template class BinnedHistogram<float>;
+template class BinnedHistogram<int>;
+template class BinnedHistogram<uint8_t>;
+template class BinnedHistogram<uint16_t>;
+
+/*the Fourier transforms are compiled for single and double precision (and the filters for every pixel type)*/
+template void mainFFT1D(std::complex<float> signal[], int start, int fin, int step1,
+                        float inv, std::complex<float> buffer[]);
+template void mainFFT1D(std::complex<double> signal[], int start, int fin, int step1,
+                        double inv, std::complex<double> buffer[]);
+template void normalize(std::complex<float> f[], int n, float norm);
+template void normalize(std::complex<double> f[], int n, double norm);
+template class FFT1D<float>;
+template class FFT1D<double>;
+template class iFFT1D<float>;
+template class iFFT1D<double>;
+template class BatchFFT1D<float>;
+template class BatchFFT1D<double>;
+template class iBatchFFT1D<float>;
+template class iBatchFFT1D<double>;
+template class FFT2D<float>;
+template class FFT2D<double>;
+template class iFFT2D<float>;
+template class iFFT2D<double>;
+template class LowpassFilter<float, int>;
+template class LowpassFilter<float, uint8_t>;
+template class LowpassFilter<float, uint16_t>;
+template class LowpassFilter<double, int>;
+template class LowpassFilter<double, uint8_t>;
+template class LowpassFilter<double, uint16_t>;
+template class HighpassFilter<float, int>;
+template class HighpassFilter<float, uint8_t>;
+template class HighpassFilter<float, uint16_t>;
+template class HighpassFilter<double, int>;
+template class HighpassFilter<double, uint8_t>;
+template class HighpassFilter<double, uint16_t>;
+template class FrequencyFilter<float, int>;
+template class FrequencyFilter<float, uint8_t>;
+template class FrequencyFilter<float, uint16_t>;
+template class FrequencyFilter<double, int>;
+template class FrequencyFilter<double, uint8_t>;
+template class FrequencyFilter<double, uint16_t>;
+template class FilterBank<float, int>;
+template class FilterBank<float, uint8_t>;
+template class FilterBank<float, uint16_t>;
+template class FilterBank<double, int>;
+template class FilterBank<double, uint8_t>;
+template class FilterBank<double, uint16_t>;
+template class FFTConvolution<float>;
+template class FFTConvolution<double>;
+template class Convolution<float>;
+template class Convolution<double>;
+template class FrequencyMask<float>;
+template class FrequencyMask<double>;
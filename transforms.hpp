@@ -9,6 +9,16 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <array>
+#include <mutex>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
+#include "fft.hpp"
+#include "parallel.hpp"
 
 
 using std::vector;
@@ -17,9 +27,48 @@ using Eigen::MatrixXd;
 using Eigen::Dynamic;
 
 
+/**
+ * @brief Column-major matrix of pixels: int, or 8-bit and 16-bit pixels kept at their native size.
+ *
+ * @tparam P Pixel type (int, uint8_t or uint16_t).
+ */
+template <typename P>
+using PixelMatrix = Eigen::Matrix<P, Dynamic, Dynamic>;
+
+/**
+ * @brief Matrix of 8-bit pixels (grayscale images).
+ */
+using MatrixXu8 = PixelMatrix<uint8_t>;
+
+/**
+ * @brief Matrix of 16-bit pixels (e.g. 16-bit tiff images).
+ */
+using MatrixXu16 = PixelMatrix<uint16_t>;
+
+/**
+ * @brief Convert a value to a pixel: floating-point values are rounded, and values out of the range
+ * of the 8-bit and 16-bit pixel types are saturated (int pixels are not clamped).
+ *
+ * @tparam P Pixel type
+ * @param value Value to convert
+ * @return P Pixel value
+ */
+template <typename P, typename V>
+inline P saturatePixel(V value) {
+    if constexpr (std::is_floating_point<V>::value) {
+        value = std::round(value);
+    }
+    if constexpr (std::numeric_limits<P>::is_integer && sizeof(P) < sizeof(int)) {
+        value = std::min(std::max(value, V(std::numeric_limits<P>::lowest())), V(std::numeric_limits<P>::max()));
+    }
+    return P(value);
+}
+
+
 /**
  * @brief Interface of transformers (i.e. desired process for input signal).
- * The class describes how the input signal is processed
+ * The class describes how the input signal is processed. Transforms are const: they keep their
+ * parameters only, so one configured transform can be used by several threads at once.
  *
  * @tparam TInput Type of the transform input (e.g., Eigen integer matrix).
  * @tparam TOutput Type of the transform output (e.g., Eigen complex matrix).
@@ -32,16 +81,318 @@ public:
      *
      * @return TOutput type Eigen matrix.
      */
-    virtual TOutput transform(const TInput& item_) = 0;
+    virtual TOutput transform(const TInput& item_) const = 0;
+
+    /**
+     * @brief Implementation of the transform writing into an output provided by the caller.
+     * An output that already has the right size is reused, so that transforming same-sized items
+     * does not allocate. By default, the result of transform(item_) is moved into the output.
+     *
+     * @param out TOutput type Eigen matrix receiving the result.
+     */
+    virtual void transform(const TInput& item_, TOutput& out) const {
+        out = transform(item_);
+    }
+
+    virtual ~Transform() = default;
+};
+
+
+/**
+ * @brief Scratch memory of the transforms, owned by the caller.
+ * A workspace is used by one thread at a time: threads sharing a transform pass their own workspace
+ * (the overloads without a workspace use the one of the calling thread, see local). Its buffers only
+ * grow, so that transforming same-sized items does not allocate.
+ */
+class TransformWorkspace {
+private:
+    std::vector<std::unique_ptr<char[]>> buffers; /// scratch arrays, by slot
+    std::vector<size_t> sizes; /// sizes in bytes of the scratch arrays
+    std::vector<std::unique_ptr<TransformWorkspace>> threads; /// workspaces of the threads of a parallel loop
+
+public:
+    /**
+     * @brief Scratch array of a slot (its content is kept until the slot is requested with a larger size).
+     *
+     * @tparam V Trivial element type
+     * @param slot Index of the array, arrays used at the same time need different slots
+     * @param n Number of elements
+     * @return V* Array of at least n elements
+     */
+    template <typename V>
+    V* buffer(int slot, size_t n) {
+        if (buffers.size() <= size_t(slot)) {
+            buffers.resize(slot + 1);
+            sizes.resize(slot + 1, 0);
+        }
+        if (sizes[slot] < n * sizeof(V)) {
+            buffers[slot].reset(new char[n * sizeof(V)]);
+            sizes[slot] = n * sizeof(V);
+        }
+        return reinterpret_cast<V*>(buffers[slot].get());
+    }
+
+    /**
+     * @brief Prepare the workspaces of the threads of a parallel loop (call before the loop).
+     *
+     * @param count Number of threads of the loop
+     */
+    void prepareThreads(int count);
+
+    /**
+     * @brief Workspace of a thread of a parallel loop (see ThreadPool::parallelFor and prepareThreads).
+     *
+     * @param index Index of the thread in the loop
+     */
+    TransformWorkspace& thread(int index);
+
+    /**
+     * @brief Workspace of the calling thread.
+     */
+    static TransformWorkspace& local();
+};
+
+
+/**
+ * @brief Clamp of n contiguous pixels to [lo, hi], in may be equal to out.
+ */
+template <typename P>
+using PixelClamp = void (*)(const P in[], P out[], size_t n, P lo, P hi);
+
+/**
+ * @brief Lookup of n contiguous 8-bit pixels in a 256-entry table (out[k] = table[in[k]]), in may be equal to out.
+ */
+using PixelLookup = void (*)(const uint8_t in[], uint8_t out[], size_t n, const uint8_t table[]);
+
+/**
+ * @brief Vectorized pixel kernels (one per instruction set).
+ */
+struct PixelKernel {
+    const char *name; /// name of the instruction set (scalar, sse4.1, avx2, avx512, avx512vbmi)
+    bool (*supported)(); /// check if the CPU supports the kernel
+    PixelClamp<uint8_t> clamp8; /// clamp of 8-bit pixels
+    PixelClamp<uint16_t> clamp16; /// clamp of 16-bit pixels
+    PixelClamp<int> clamp32; /// clamp of int pixels
+    PixelLookup lookup8; /// table lookup of 8-bit pixels
+
+    /**
+     * @brief Clamp for the pixel type P.
+     */
+    template <typename P>
+    PixelClamp<P> clamp() const;
+};
+
+template <>
+inline PixelClamp<uint8_t> PixelKernel::clamp<uint8_t>() const {
+    return clamp8;
+}
+
+template <>
+inline PixelClamp<uint16_t> PixelKernel::clamp<uint16_t>() const {
+    return clamp16;
+}
+
+template <>
+inline PixelClamp<int> PixelKernel::clamp<int>() const {
+    return clamp32;
+}
+
+/**
+ * @brief Pixel kernel used by the transforms.
+ * By default the widest kernel supported by the CPU (detected at runtime with CPUID).
+ */
+const PixelKernel& pixelKernel();
+
+/**
+ * @brief Name of the pixel kernel used by the transforms (e.g., for logs).
+ */
+std::string pixelKernelName();
+
+/**
+ * @brief Names of the pixel kernels supported by the CPU, from the widest to the narrowest.
+ */
+std::vector<std::string> availablePixelKernels();
+
+/**
+ * @brief Force the pixel kernel used by the transforms (e.g., for testing and benchmarking).
+ * Throws std::invalid_argument if the kernel does not exist or is not supported by the CPU.
+ *
+ * @param name Name of the kernel
+ */
+void setPixelKernel(const std::string& name);
+
+
+/**
+ * @brief Pointwise transform of 8-bit pixels by a 256-entry lookup table (out(i, j) = table[item(i, j)]).
+ * Any function of an 8-bit pixel is evaluated once per pixel value when the table is built, then the table is
+ * applied with the lookup kernel of pixelKernel(); large frames are split into stripes of columns over the
+ * threads of ThreadPool::global().
+ */
+class LUTTransform: public Transform<MatrixXu8, MatrixXu8> {
+protected:
+    std::array<uint8_t, 256> table; /// output of every pixel value
+
+public:
+    using Transform<MatrixXu8, MatrixXu8>::transform;
+
+    /**
+    * @brief Constructor for LUTTransform with the identity table
+    */
+    explicit LUTTransform();
+
+    /**
+    * @brief Constructor for LUTTransform with a given table
+    *
+    * @param table_ output of every pixel value
+    */
+    explicit LUTTransform(const std::array<uint8_t, 256>& table_);
+
+    /**
+     * @brief Table of a function of the pixel values (its results are rounded and saturated to [0, 255]).
+     *
+     * @param f Function called once with every pixel value (0 to 255, as int)
+     * @return LUTTransform Transform applying f to the pixels
+     */
+    template <typename F>
+    static LUTTransform fromFunction(const F& f) {
+        std::array<uint8_t, 256> values;
+        for (int v = 0; v < 256; ++v) {
+            values[v] = saturatePixel<uint8_t>(f(v));
+        }
+        return LUTTransform(values);
+    }
+
+    /**
+     * @brief Get the table of the transform.
+     */
+    const std::array<uint8_t, 256>& getTable() const;
+
+    /**
+     * @brief Fusion of this transform followed by another one: the composed table transforms the pixels in
+     * a single pass (one read and one write per pixel, whatever the length of the chain).
+     *
+     * @param next Transform applied to the output of this one
+     * @return LUTTransform Transform with table next[table[v]]
+     */
+    LUTTransform then(const LUTTransform& next) const;
+
+    /**
+     * @brief Implementation of the table lookup.
+     *
+     * @return Eigen 8-bit matrix of the transformed pixels.
+     */
+    MatrixXu8 transform(const MatrixXu8& item) const override;
+
+    /**
+     * @brief Implementation of the table lookup writing into a preallocated output
+     * (reused without allocation if it has the right size, out may be item).
+     *
+     * @param item Eigen 8-bit matrix of the image
+     * @param out Eigen 8-bit matrix for the transformed image
+     */
+    void transform(const MatrixXu8& item, MatrixXu8& out) const override;
+
+    /**
+     * @brief Implementation of the table lookup overwriting its input.
+     *
+     * @param item Eigen 8-bit matrix transformed in place
+     */
+    void transformInPlace(MatrixXu8& item) const;
+};
+
+
+/**
+ * @brief Gamma correction of 8-bit pixels: 255 (v / 255)^gamma.
+ */
+class GammaCorrection: public LUTTransform {
+public:
+    /**
+    * @brief Constructor for GammaCorrection with specified exponent
+    *
+    * @param gamma exponent (< 1 brightens the image, > 1 darkens it)
+    */
+    explicit GammaCorrection(double gamma);
+};
+
+
+/**
+ * @brief Linear contrast stretch of 8-bit pixels: [low, high] is mapped to [0, 255], the pixels out of
+ * [low, high] are saturated.
+ */
+class ContrastStretch: public LUTTransform {
+public:
+    /**
+    * @brief Constructor for ContrastStretch with specified input range
+    *
+    * @param low pixel value mapped to 0
+    * @param high pixel value mapped to 255
+    */
+    explicit ContrastStretch(int low, int high);
+};
+
+
+/**
+ * @brief Histogram equalization of 8-bit pixels: every pixel is mapped to the fraction of the pixels that are not
+ * brighter, rescaled to [0, 255]. The table of every image is built from its histogram counts and applied as a
+ * LUTTransform.
+ */
+class HistogramEqualization: public Transform<MatrixXu8, MatrixXu8> {
+public:
+    using Transform<MatrixXu8, MatrixXu8>::transform;
+
+    /**
+    * @brief Constructor for HistogramEqualization
+    */
+    explicit HistogramEqualization();
+
+    /**
+     * @brief Table equalizing the images with a given histogram (e.g. to equalize a stream of frames with the
+     * histogram of a reference frame).
+     *
+     * @param histogram Output of Histogram<uint8_t> (fractions of the pixels from the minimum to the maximum)
+     * @param low Minimum pixel value (value of the first bin)
+     * @return LUTTransform Transform equalizing the pixels
+     */
+    static LUTTransform table(const MatrixXd& histogram, int low);
+
+    /**
+     * @brief Implementation of the histogram equalization.
+     *
+     * @return Eigen 8-bit matrix of the equalized image.
+     */
+    MatrixXu8 transform(const MatrixXu8& item) const override;
+
+    /**
+     * @brief Implementation of the histogram equalization writing into a preallocated output
+     * (reused without allocation if it has the right size, out may be item).
+     *
+     * @param item Eigen 8-bit matrix of the image
+     * @param out Eigen 8-bit matrix for the equalized image
+     */
+    void transform(const MatrixXu8& item, MatrixXu8& out) const override;
+
+    /**
+     * @brief Implementation of the histogram equalization with the scratch memory of the caller.
+     *
+     * @param item Eigen 8-bit matrix of the image
+     * @param out Eigen 8-bit matrix for the equalized image (may be item)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const MatrixXu8& item, MatrixXu8& out, TransformWorkspace& workspace) const;
 };
 
 
 /**
  * @brief transformer for filter thresholding the grayscale.
+ * The pixels are clamped with the vector kernel of pixelKernel(); large frames are split into
+ * stripes of columns (contiguous in memory) over the threads of ThreadPool::global().
+ *
+ * @tparam P Pixel type (int, uint8_t or uint16_t).
  */
-class Thresholding: public Transform<MatrixXi, MatrixXi> {
+template <typename P = int>
+class Thresholding: public Transform<PixelMatrix<P>, PixelMatrix<P>> {
 private:
-    int thr_min, thr_max; /// lower and upper threshold
+    P thr_min, thr_max; /// lower and upper threshold (saturated to the range of the pixels)
 
 public:
     /**
@@ -55,17 +406,58 @@ public:
     /**
      * @brief Implementation of the thresholding transform.
      *
-     * @return Eigen integer matrix for the filtered space domain.
+     * @return Eigen pixel matrix for the filtered space domain.
+     */
+    PixelMatrix<P> transform(const PixelMatrix<P>& item) const override;
+
+    /**
+     * @brief Implementation of the thresholding transform writing into a preallocated output
+     * (reused without allocation if it has the right size, out may be item).
+     *
+     * @param item Eigen pixel matrix to threshold
+     * @param out Eigen pixel matrix for the thresholded image
      */
-    MatrixXi transform(const MatrixXi& item) override;
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out) const override;
+
+    /**
+     * @brief Implementation of the thresholding transform overwriting its input (no output buffer is touched).
+     *
+     * @param item Eigen pixel matrix thresholded in place
+     */
+    void transformInPlace(PixelMatrix<P>& item) const;
+
+    /**
+     * @brief Table of the thresholding of 8-bit pixels (the thresholds are saturated to [0, 255]),
+     * e.g. to fuse it with other lookup tables.
+     *
+     * @return LUTTransform Transform thresholding 8-bit pixels
+     */
+    LUTTransform toLUT() const;
+
+    /**
+     * @brief Fusion of this thresholding followed by another one (a clamp of a clamp is a clamp).
+     *
+     * @param next Thresholding applied to the output of this one
+     * @return Thresholding<P> Thresholding with the same output in a single pass
+     */
+    Thresholding<P> then(const Thresholding<P>& next) const;
 };
 
 
 /**
  * @brief transformer for calculating the grayscale intensity histogram.
+ * The pixels are counted in uint32 bins (four interleaved sub-histograms for narrow ranges), one count
+ * table per stripe of columns for large frames, merged and normalized once at the end. 8-bit images
+ * (and large 16-bit ones) are counted in a table of the whole pixel range, other images in tables grown
+ * to the range of the values met so far: the minimum and the maximum come from the same single pass.
+ *
+ * @tparam P Pixel type (int, uint8_t or uint16_t).
  */
-class Histogram: public Transform<MatrixXi, MatrixXd> {
+template <typename P = int>
+class Histogram: public Transform<PixelMatrix<P>, MatrixXd> {
 public:
+    using Transform<PixelMatrix<P>, MatrixXd>::transform;
+
     /**
     * @brief Constructor for Histogram with specified thresholding arguments
     */
@@ -76,44 +468,147 @@ public:
      *
      * @return Eigen double matrix for the calculated intensity histogram.
      */
-    MatrixXd transform(const MatrixXi& item) override;
+    MatrixXd transform(const PixelMatrix<P>& item) const override;
+
+    /**
+     * @brief Implementation of the histogram transform writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen pixel matrix of the image
+     * @param out Eigen double row for the histogram (bins from the minimum to the maximum pixel)
+     */
+    void transform(const PixelMatrix<P>& item, MatrixXd& out) const override;
+
+    /**
+     * @brief Implementation of the histogram transform with the scratch memory of the caller.
+     *
+     * @param item Eigen pixel matrix of the image
+     * @param out Eigen double row for the histogram (bins from the minimum to the maximum pixel)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const PixelMatrix<P>& item, MatrixXd& out, TransformWorkspace& workspace) const;
 };
 
 
+/**
+ * @brief transformer for calculating a histogram with a fixed number of bins over a fixed range of values,
+ * e.g. level histograms of audio samples or HDR images. The bins have the same width, the bin of a value is
+ * found with one multiplication by the reciprocal of the width; values out of the range are counted in the first
+ * or the last bin (NaN in the first). The counting is the one of Histogram.
+ *
+ * @tparam V Value type (double, float, int, uint8_t or uint16_t).
+ */
+template <typename V = double>
+class BinnedHistogram: public Transform<PixelMatrix<V>, MatrixXd> {
+private:
+    int bins; /// number of bins
+    double low, high; /// range of the values, [low, high] is split into the bins
+
+public:
+    using Transform<PixelMatrix<V>, MatrixXd>::transform;
+
+    /**
+    * @brief Constructor for BinnedHistogram with specified bins
+    *
+    * @param bins_ number of bins
+    * @param low_ lower bound of the first bin
+    * @param high_ upper bound of the last bin
+    */
+    explicit BinnedHistogram(int bins_, double low_, double high_);
+
+    /**
+     * @brief Implementation of the histogram transform.
+     *
+     * @return Eigen double row of the fraction of the values in every bin.
+     */
+    MatrixXd transform(const PixelMatrix<V>& item) const override;
+
+    /**
+     * @brief Implementation of the histogram transform writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen matrix of the values
+     * @param out Eigen double row for the histogram (one column per bin)
+     */
+    void transform(const PixelMatrix<V>& item, MatrixXd& out) const override;
+
+    /**
+     * @brief Implementation of the histogram transform with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix of the values
+     * @param out Eigen double row for the histogram (one column per bin)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const PixelMatrix<V>& item, MatrixXd& out, TransformWorkspace& workspace) const;
+};
+
+
+/**
+ * @brief Complex row vector of the given precision (spectrum of FFT1D).
+ */
+template <typename T>
+using ComplexRow = Eigen::Matrix<std::complex<T>, 1, Dynamic>;
+
+/**
+ * @brief Complex matrix of the given precision (spectrum of FFT2D).
+ */
+template <typename T>
+using ComplexMatrix = Eigen::Matrix<std::complex<T>, Dynamic, Dynamic>;
+
+/**
+ * @brief Real row vector of the given precision (magnitude or phase of FFT1D).
+ */
+template <typename T>
+using RealRow = Eigen::Matrix<T, 1, Dynamic>;
+
+/**
+ * @brief Real matrix of the given precision (magnitude or phase of FFT2D).
+ */
+template <typename T>
+using RealMatrix = Eigen::Matrix<T, Dynamic, Dynamic>;
+
+
 /**
  * @brief mainbody of the 1D Fast Fourier Transform realized with Cooley–Tukey FFT algorithm.
+ * Runs the selected FFTBackend (by default the cached FFTPlan of the corresponding size) on the strided signal.
  *
+ * @tparam T Precision of the computation (float or double).
  * @param signal[] whole signal being transformed
  * @param start beginning position of the signal being processed at current step
  * @param fin ending position of the signal being processed at current step
  * @param step1 step of the FFT transform
  * @param inv for FFT, inv = -1, for inverse FFT, inv = 1
- * @param buffer[] float complex array for temporarily store transformed results
+ * @param buffer[] complex array for gathering the strided signal
  */
-void mainFFT1D(std::complex<float> signal[], int start, int fin, int step1, float inv, std::complex<float> buffer[]);
+template <typename T>
+void mainFFT1D(std::complex<T> signal[], int start, int fin, int step1, T inv, std::complex<T> buffer[]);
 
 /**
  * @brief normalization of the FFT transformed results, assuring signal remains constant after FFT and then inverse FFT.
  *
- * @param f[] float complex array being normalized
+ * @tparam T Precision of the computation (float or double).
+ * @param f[] complex array being normalized
  * @param n size of f[]
  * @param norm normalization divider
  */
-void normalize(std::complex<float> f[], int n, float norm);
+template <typename T>
+void normalize(std::complex<T> f[], int n, T norm);
 
 
 /**
  * @brief Fast Fourier transform in 1D
- * 
+ *
+ * @tparam T Precision of the computation and of the spectrum: float for throughput
+ * (half the memory), double for accuracy.
  */
-class FFT1D: public Transform<MatrixXi, Eigen::Matrix<std::complex<double>,1, Dynamic>> {
+template <typename T = double>
+class FFT1D: public Transform<MatrixXi, ComplexRow<T>> {
 private:
-    Eigen::Matrix<std::complex<double>,1, Dynamic> mfrequencyDomain; /// frequency of the transform
-    Eigen::Matrix<std::complex<double>,1, Dynamic> mMagnitude; /// magnitude of the transform
     int step; /// number of steps
-    int transformed; /// flag if the transform has been applied
 
 public:
+    using Transform<MatrixXi, ComplexRow<T>>::transform;
+
     FFT1D(int n = 1);
 
     /**
@@ -121,102 +616,648 @@ public:
      *
      * @return Eigen complex matrix for the Fourier transform.
      */
-    Eigen::Matrix<std::complex<double>,1, Dynamic> transform(const MatrixXi& item) override;
+    ComplexRow<T> transform(const MatrixXi& item) const override;
 
     /**
-     * @brief Get the Magnitude object
+     * @brief Get the Magnitude object of a spectrum
      * 
-     * @return Eigen::Matrix<std::complex<double>,1, Dynamic> Magnitude matrix
+     * @param spectrum Spectrum returned by transform
+     * @return RealRow<T> Magnitude matrix |X|
      */
-    Eigen::Matrix<std::complex<double>,1, Dynamic> getMagnitude();
+    static RealRow<T> getMagnitude(const ComplexRow<T>& spectrum);
+
+    /**
+     * @brief Get the phase of a spectrum
+     * 
+     * @param spectrum Spectrum returned by transform
+     * @return RealRow<T> Phase matrix arg(X), in [-pi, pi]
+     */
+    static RealRow<T> getPhase(const ComplexRow<T>& spectrum);
+
+    /**
+     * @brief Get the log-magnitude of a spectrum, for display
+     * 
+     * @param spectrum Spectrum returned by transform
+     * @return RealRow<T> Log-magnitude matrix log(1 + |X|)
+     */
+    static RealRow<T> getLogMagnitude(const ComplexRow<T>& spectrum);
 };
 
 
 /**
  * @brief Inverse Fast Fourier transform in 1d
- * 
+ *
+ * @tparam T Precision of the computation and of the input spectrum (float or double).
  */
-class iFFT1D: public Transform<Eigen::Matrix<std::complex<double>,1, -1>, Eigen::Matrix<int,1, -1>> {
-private:
-    Eigen::Matrix<int,1, Dynamic> mspatialDomain; /// transform results in the spatial domain
-    int transformed = 0; /// flag if the transform has been applied
-
+template <typename T = double>
+class iFFT1D: public Transform<ComplexRow<T>, Eigen::Matrix<int,1, -1>> {
 public:
+    using Transform<ComplexRow<T>, Eigen::Matrix<int,1, -1>>::transform;
+
     /**
     * @brief Implementation of the inverse Fast Fourier transform in 1D
     * 
     * @param item Input matrix in Fourier domain
     * @return Eigen::Matrix<int,1, Dynamic> Output matrix in spatial domain
     */
-    Eigen::Matrix<int,1, Dynamic> transform(const Eigen::Matrix<std::complex<double>,1, -1>& item) override;
+    Eigen::Matrix<int,1, Dynamic> transform(const ComplexRow<T>& item) const override;
+};
+
+
+/**
+ * @brief Direction along which the signals of a batched transform are laid out.
+ */
+enum class FFTAxis {
+    Rows, /// every row is a signal
+    Columns /// every column is a signal
+};
+
+
+/**
+ * @brief Batched Fast Fourier transform in 1D: every row (or column) of the input is transformed
+ * independently, e.g. the frames of an audio signal or the scanlines of an image.
+ * All signals share one plan, and the batch is split between the threads of the global pool,
+ * each of them reusing one workspace for all its signals.
+ *
+ * @tparam T Precision of the computation and of the spectra (float or double).
+ */
+template <typename T = double>
+class BatchFFT1D: public Transform<MatrixXi, ComplexMatrix<T>> {
+private:
+    FFTAxis axis; /// direction of the signals
+
+public:
+    /**
+     * @brief Construct a new BatchFFT1D object
+     *
+     * @param axis_ Direction of the signals in the input matrix
+     */
+    explicit BatchFFT1D(FFTAxis axis_ = FFTAxis::Rows);
+
+    /**
+     * @brief Transform every signal of the input, normalized by the square root of its length.
+     *
+     * @param item Matrix of signals
+     * @return ComplexMatrix<T> Matrix of spectra (same layout as the input)
+     */
+    ComplexMatrix<T> transform(const MatrixXi& item) const override;
+
+    /**
+     * @brief Transform every signal of the input into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Matrix of signals
+     * @param out Matrix of spectra (same layout as the input)
+     */
+    void transform(const MatrixXi& item, ComplexMatrix<T>& out) const override;
+
+    /**
+     * @brief Transform every signal of the input with the scratch memory of the caller.
+     *
+     * @param item Matrix of signals
+     * @param out Matrix of spectra (same layout as the input)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const MatrixXi& item, ComplexMatrix<T>& out, TransformWorkspace& workspace) const;
+};
+
+
+/**
+ * @brief Batched inverse Fast Fourier transform in 1D: every row (or column) of the input spectrum
+ * is transformed back independently (see BatchFFT1D).
+ *
+ * @tparam T Precision of the computation and of the input spectra (float or double).
+ */
+template <typename T = double>
+class iBatchFFT1D: public Transform<ComplexMatrix<T>, Eigen::Matrix<int,-1, -1>> {
+private:
+    FFTAxis axis; /// direction of the signals
+
+public:
+    /**
+     * @brief Construct a new iBatchFFT1D object
+     *
+     * @param axis_ Direction of the spectra in the input matrix
+     */
+    explicit iBatchFFT1D(FFTAxis axis_ = FFTAxis::Rows);
+
+    /**
+     * @brief Transform back every spectrum of the input, normalized by the square root of its length.
+     *
+     * @param item Matrix of spectra
+     * @return Eigen::Matrix<int,-1, -1> Matrix of signals (same layout as the input)
+     */
+    Eigen::Matrix<int,-1, -1> transform(const ComplexMatrix<T>& item) const override;
+
+    /**
+     * @brief Transform back every spectrum of the input into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Matrix of spectra
+     * @param out Matrix of signals (same layout as the input)
+     */
+    void transform(const ComplexMatrix<T>& item, Eigen::Matrix<int,-1, -1>& out) const override;
+
+    /**
+     * @brief Transform back every spectrum of the input with the scratch memory of the caller.
+     *
+     * @param item Matrix of spectra
+     * @param out Matrix of signals (same layout as the input)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const ComplexMatrix<T>& item, Eigen::Matrix<int,-1, -1>& out, TransformWorkspace& workspace) const;
 };
 
 
 /**
  * @brief Fast Fourier Fourier transform in 2d
- * 
+ *
+ * @tparam T Precision of the computation and of the spectrum: float for throughput
+ * (half the memory), double for accuracy.
  */
-class FFT2D: public Transform<MatrixXi, Eigen::Matrix<std::complex<double>,-1, -1>> {
+template <typename T = double>
+class FFT2D: public Transform<MatrixXi, ComplexMatrix<T>> {
 private:
-    Eigen::Matrix<std::complex<double>,-1, -1> mfrequencyDomain; /// frequency of the transform
-    Eigen::Matrix<std::complex<double>,-1, -1> mMagnitude; /// magnitude of the transform
     int step; /// number of steps
-    int transformed; /// flag if the transform has been applied
+    bool halfSpectrum; /// flag if only the non-redundant half spectrum (rows x (cols/2+1)) is computed
 
 public:
     /**
      * @brief Construct a new FFT2D object with the specified number of steps
      * 
      * @param n Number of steps
+     * @param halfSpectrum_ Compute only the rows x (cols/2+1) non-redundant half of the Hermitian spectrum
+     * of the real input (r2c mode, requires n = 1)
      */
-    FFT2D(int n = 1);
+    FFT2D(int n = 1, bool halfSpectrum_ = false);
 
     /**
      * @brief Implementation of the FFT1D transform.
      *
      * @return Eigen complex matrix for the Fourier transform.
      */
-    Eigen::Matrix<std::complex<double>,-1, -1> transform(const MatrixXi& item) override;
+    ComplexMatrix<T> transform(const MatrixXi& item) const override;
+
+    /**
+     * @brief Implementation of the FFT2D transform writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen integer matrix of the image
+     * @param out Eigen complex matrix for the Fourier transform
+     */
+    void transform(const MatrixXi& item, ComplexMatrix<T>& out) const override;
+
+    /**
+     * @brief Implementation of the FFT2D transform with the scratch memory of the caller.
+     *
+     * @param item Eigen integer matrix of the image
+     * @param out Eigen complex matrix for the Fourier transform
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const MatrixXi& item, ComplexMatrix<T>& out, TransformWorkspace& workspace) const;
+
+    /**
+     * @brief Get the Magnitude object of a spectrum
+     * 
+     * @param spectrum Spectrum returned by transform
+     * @return RealMatrix<T> Magnitude matrix |X|
+     */
+    static RealMatrix<T> getMagnitude(const ComplexMatrix<T>& spectrum);
 
     /**
-     * @brief Get the Magnitude object
+     * @brief Get the phase of a spectrum
      * 
-     * @return Eigen::Matrix<std::complex<double>,1, Dynamic> Magnitude matrix
+     * @param spectrum Spectrum returned by transform
+     * @return RealMatrix<T> Phase matrix arg(X), in [-pi, pi]
      */
-    Eigen::Matrix<std::complex<double>,-1, -1> getMagnitude();
+    static RealMatrix<T> getPhase(const ComplexMatrix<T>& spectrum);
+
+    /**
+     * @brief Get the log-magnitude of a spectrum, for display
+     * 
+     * @param spectrum Spectrum returned by transform
+     * @return RealMatrix<T> Log-magnitude matrix log(1 + |X|)
+     */
+    static RealMatrix<T> getLogMagnitude(const ComplexMatrix<T>& spectrum);
 };
 
 
 /**
  * @brief Inverse Fast Fourier transform in 2d
- * 
+ *
+ * @tparam T Precision of the computation and of the input spectrum (float or double).
  */
-class iFFT2D: public Transform<Eigen::Matrix<std::complex<double>,-1, -1>, Eigen::Matrix<int,-1, -1>> {
+template <typename T = double>
+class iFFT2D: public Transform<ComplexMatrix<T>, Eigen::Matrix<int,-1, -1>> {
 private:
-    Eigen::Matrix<int,-1, -1> mspatialDomain; /// transform results in the spatial domain
-    int transformed = 0; /// flag if the transform has been applied
+    int fullCols; /// number of output columns for a half spectrum input, 0 for a full spectrum input
 
 public:
+    /**
+     * @brief Construct a new iFFT2D object
+     * 
+     * @param fullCols_ 0 if the input is a full spectrum, otherwise the input is the half spectrum
+     * returned by FFT2D in half-spectrum mode (c2r mode) for an image with fullCols_ columns
+     */
+    explicit iFFT2D(int fullCols_ = 0);
+
     /**
      * @brief Implementation of the inverse Fast Fourier transform in 1D
      * 
      * @param item Input matrix in Fourier domain
      * @return Eigen::Matrix<int,1, Dynamic> Output matrix in spatial domain
      */
-    Eigen::Matrix<int,-1, -1> transform(const Eigen::Matrix<std::complex<double>,-1, -1>& item) override;
+    Eigen::Matrix<int,-1, -1> transform(const ComplexMatrix<T>& item) const override;
+
+    /**
+     * @brief Implementation of the inverse FFT2D transform writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Input matrix in Fourier domain
+     * @param out Output matrix in spatial domain
+     */
+    void transform(const ComplexMatrix<T>& item, Eigen::Matrix<int,-1, -1>& out) const override;
+
+    /**
+     * @brief Implementation of the inverse FFT2D transform with the scratch memory of the caller.
+     *
+     * @param item Input matrix in Fourier domain
+     * @param out Output matrix in spatial domain
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const ComplexMatrix<T>& item, Eigen::Matrix<int,-1, -1>& out, TransformWorkspace& workspace) const;
+};
+
+
+/**
+ * @brief Frequency-domain filter: shape and parameters.
+ * Distances D are measured in frequency samples from DC, i.e. from (0, 0) of the unshifted spectrum, wrapping
+ * around its edges. The ideal filters keep the convention of LowpassFilter and HighpassFilter (distance to
+ * (rows/2, cols/2)) and have a hard cutoff (and ring), the others are smooth:
+ * - Gaussian: exp(-D^2 / (2 cutoff^2)) (lowpass) and 1 minus it (highpass);
+ * - Butterworth: 1 / (1 + (D / cutoff)^(2 order)) (lowpass) and 1 / (1 + (cutoff / D)^(2 order)) (highpass);
+ * - band-pass: Butterworth highpass at cutoff times Butterworth lowpass at cutoff2;
+ * - notch: Butterworth highpass of radius cutoff around the frequency (notchRow, notchCol),
+ *   times the same around its mirror (rejects a periodic pattern).
+ */
+struct FilterSpec {
+    /**
+     * @brief Shape of the filter.
+     */
+    enum Type {
+        IdealLowpass, IdealHighpass, GaussianLowpass, GaussianHighpass,
+        ButterworthLowpass, ButterworthHighpass, Bandpass, Notch
+    };
+
+    Type type; /// shape of the filter
+    double cutoff; /// cutoff radius (lower cutoff of a band-pass, radius of a notch)
+    double cutoff2 = 0; /// upper cutoff of a band-pass
+    int order = 1; /// order of the Butterworth, band-pass and notch filters
+    int notchRow = 0; /// row offset of the notch from DC
+    int notchCol = 0; /// column offset of the notch from DC
+
+    /**
+     * @brief Check the parameters of the filter.
+     * Throws std::invalid_argument if the cutoff of a smooth filter is not positive, if the order
+     * is not positive, or if the band of a band-pass is empty.
+     */
+    void validate() const;
+
+    bool operator<(const FilterSpec& other) const;
+};
+
+
+/**
+ * @brief Weights of a frequency-domain filter for the spectra of a given shape.
+ * The weights are laid out as the spectrum returned by FFT2D (column-major, full or half spectrum), so that
+ * a filter is applied as an element-wise product. Masks are built once and cached by shape and filter, so
+ * filtering many frames of the same size does not recompute them.
+ *
+ * @tparam T Precision of the weights (float or double).
+ */
+template <typename T>
+class FrequencyMask {
+private:
+    std::vector<T> weights; /// weight of every coefficient, column-major
+    int nrows; /// number of rows of the spectrum
+    int width; /// number of columns of the spectrum (cols/2+1 for a half spectrum)
+
+public:
+    /**
+     * @brief Compute the mask of a filter.
+     * On a half spectrum every weight is averaged with the one of its Hermitian mirror (-i, -j),
+     * so that the real inverse gives the real part of the inverse of the filtered full spectrum.
+     *
+     * @param spec Filter
+     * @param nrows_ Number of rows of the image
+     * @param ncols Number of columns of the image
+     * @param halfSpectrum Compute the weights of the rows x (cols/2+1) half spectrum
+     */
+    FrequencyMask(const FilterSpec& spec, int nrows_, int ncols, bool halfSpectrum);
+
+    /**
+     * @brief Get a shared mask (built on first request and cached).
+     */
+    static std::shared_ptr<const FrequencyMask<T>> get(const FilterSpec& spec, int nrows, int ncols, bool halfSpectrum);
+
+    /**
+     * @brief Weights in column-major order.
+     */
+    const T* data() const;
+
+    /**
+     * @brief Number of rows of the mask.
+     */
+    int rows() const;
+
+    /**
+     * @brief Number of columns of the mask.
+     */
+    int cols() const;
+
+    /**
+     * @brief Weight of the coefficient (i, j).
+     */
+    T operator()(int i, int j) const;
+};
+
+
+/**
+ * @brief Frequency-domain filter using 2d Fourier transforms (any FilterSpec, e.g. Gaussian or Butterworth).
+ * The weights of the filter are precomputed once per image shape (see FrequencyMask) and multiplied
+ * with the spectrum in the first pass of the inverse transform.
+ *
+ * @tparam T Precision of the Fourier transforms (float or double).
+ * @tparam P Pixel type of the images (int, uint8_t or uint16_t).
+ */
+template <typename T = double, typename P = int>
+class FrequencyFilter : public Transform<PixelMatrix<P>, PixelMatrix<P>> {
+private:
+    FilterSpec spec; /// shape and parameters of the filter
+
+public:
+    /**
+     * @brief Construct a new Frequency Filter object
+     * Throws std::invalid_argument if the parameters are not valid.
+     *
+     * @param spec_ Shape and parameters of the filter
+     */
+    explicit FrequencyFilter(const FilterSpec& spec_);
+
+    /**
+     * @brief Apply the filter
+     *
+     * @param item Eigen matrix before filtering
+     * @return PixelMatrix<P> Eigen matrix after filtering
+     */
+    PixelMatrix<P> transform(const PixelMatrix<P>& item) const override;
+
+    /**
+     * @brief Apply the filter writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Eigen matrix after filtering
+     */
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out) const override;
+
+    /**
+     * @brief Apply the filter with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Eigen matrix after filtering
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out, TransformWorkspace& workspace) const;
+};
+
+
+/**
+ * @brief Bank of frequency-domain filters applied to the same image.
+ * The forward FFT2D is computed once, then every filter mask is applied to a copy of the spectrum and
+ * transformed back, the inverse transforms of the different filters running in parallel.
+ * E.g. a sweep of 8 cutoffs costs 1 forward and 8 inverse transforms instead of 8 of each.
+ *
+ * @tparam T Precision of the Fourier transforms (float or double).
+ * @tparam P Pixel type of the images (int, uint8_t or uint16_t).
+ */
+template <typename T = double, typename P = int>
+class FilterBank : public Transform<PixelMatrix<P>, std::vector<PixelMatrix<P>>> {
+private:
+    std::vector<FilterSpec> specs; /// filters of the bank
+
+public:
+    /**
+     * @brief Construct a new Filter Bank object
+     *
+     * @param specs_ Filters of the bank
+     */
+    explicit FilterBank(const std::vector<FilterSpec>& specs_);
+
+    /**
+     * @brief Apply all the filters of the bank.
+     *
+     * @param item Eigen matrix before filtering
+     * @return std::vector<PixelMatrix<P>> Filtered images, in the order of the filters
+     */
+    std::vector<PixelMatrix<P>> transform(const PixelMatrix<P>& item) const override;
+
+    /**
+     * @brief Apply all the filters of the bank into preallocated outputs
+     * (reused without allocation if they have the right size).
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Filtered images, in the order of the filters
+     */
+    void transform(const PixelMatrix<P>& item, std::vector<PixelMatrix<P>>& out) const override;
+
+    /**
+     * @brief Apply all the filters of the bank with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Filtered images, in the order of the filters
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const PixelMatrix<P>& item, std::vector<PixelMatrix<P>>& out, TransformWorkspace& workspace) const;
+};
+
+
+/**
+ * @brief Convolution of an image with an arbitrary kernel by tiled FFTs (overlap-save).
+ * The image is cut into tiles whose transforms and buffers fit in the L2 cache; every tile is
+ * transformed, multiplied with the (precomputed) spectrum of the kernel and transformed back, and the
+ * part of the tile that is not polluted by the circular wrap-around is kept. Tiles are processed in
+ * parallel, every thread holding the buffers of one tile only, so that the memory used besides the
+ * input and output does not grow with the image (unlike FFT2D, which needs the spectrum of the whole image).
+ *
+ * The output has the size of the image ("same" convolution): out(i, j) = sum K(a, b) item(i + kr/2 - a, j + kc/2 - b)
+ * for a kr x kc kernel K, the image being zero outside its bounds.
+ *
+ * @tparam T Precision of the Fourier transforms (float or double).
+ */
+template <typename T = double>
+class FFTConvolution : public Transform<MatrixXi, MatrixXd> {
+private:
+    MatrixXd kernel; /// convolution kernel
+    int tileSize; /// size of the (square) tiles, 0 to choose it from the kernel and the cache size
+    /// spectra of the kernel by tile shape (column-major half spectra), computed on first use
+    mutable std::map<std::pair<int, int>, std::shared_ptr<const std::vector<std::complex<T>>>> kernelSpectra;
+    mutable std::mutex spectraMutex; /// guards kernelSpectra
+
+    /**
+     * @brief Spectrum of the kernel for a tile shape (computed once per shape, thread-safe).
+     */
+    std::shared_ptr<const std::vector<std::complex<T>>> kernelSpectrum(int tileRows, int tileCols) const;
+
+public:
+    /**
+     * @brief Construct a new FFT Convolution object
+     * Throws std::invalid_argument if the kernel is empty or larger than the tiles.
+     *
+     * @param kernel_ Convolution kernel
+     * @param tileSize_ Size of the square tiles (FFT size, including the overlap), 0 to choose it automatically
+     */
+    explicit FFTConvolution(const MatrixXd& kernel_, int tileSize_ = 0);
+
+    /**
+     * @brief Shape of the tiles (FFT sizes) used for an image of the given size.
+     *
+     * @param nrows number of rows of the image
+     * @param ncols number of columns of the image
+     * @param tileRows number of rows of the tiles
+     * @param tileCols number of columns of the tiles
+     */
+    void tileShape(int nrows, int ncols, int& tileRows, int& tileCols) const;
+
+    /**
+     * @brief Convolve an image with the kernel
+     *
+     * @param item Eigen matrix of the image
+     * @return MatrixXd Eigen matrix of the convolved image (same size)
+     */
+    MatrixXd transform(const MatrixXi& item) const override;
+
+    /**
+     * @brief Convolve an image with the kernel writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen matrix of the image
+     * @param out Eigen matrix of the convolved image (same size)
+     */
+    void transform(const MatrixXi& item, MatrixXd& out) const override;
+
+    /**
+     * @brief Convolve an image with the kernel with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix of the image
+     * @param out Eigen matrix of the convolved image (same size)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const MatrixXi& item, MatrixXd& out, TransformWorkspace& workspace) const;
+};
+
+
+/**
+ * @brief Algorithm of a convolution.
+ */
+enum class ConvolutionMethod {
+    Auto, /// chosen by the cost model for every image
+    Direct, /// sum over the taps of the kernel
+    Separable, /// two 1d passes (rank-one kernels only)
+    FFT /// tiled FFT convolution (FFTConvolution)
+};
+
+
+/**
+ * @brief Convolution of an image with an arbitrary kernel, by the cheapest algorithm.
+ * The direct convolution adds scaled columns of the zero-padded image (a loop the compiler vectorizes),
+ * a separable (rank-one) kernel is applied as a column pass and a row pass, and large kernels go
+ * through the tiled FFTs of FFTConvolution. With ConvolutionMethod::Auto, the method is chosen per
+ * image from the kernel size, its separability and the image size (see choose), so that e.g. a 3x3
+ * or 5x5 kernel never pays for Fourier transforms.
+ *
+ * The output is the same as FFTConvolution: out(i, j) = sum K(a, b) item(i + kr/2 - a, j + kc/2 - b),
+ * the image being zero outside its bounds.
+ *
+ * @tparam T Precision of the computations (float or double).
+ */
+template <typename T = double>
+class Convolution : public Transform<MatrixXi, MatrixXd> {
+private:
+    std::vector<T> weights; /// kernel (column-major)
+    int kernelRows; /// number of rows of the kernel
+    int kernelCols; /// number of columns of the kernel
+    ConvolutionMethod method; /// requested method
+    bool separable; /// flag if the kernel is the product of a column and a row
+    std::vector<T> columnFactor; /// column factor of a separable kernel
+    std::vector<T> rowFactor; /// row factor of a separable kernel
+    FFTConvolution<T> fft; /// FFT path (keeps the spectra of the kernel)
+
+public:
+    /**
+     * @brief Construct a new Convolution object
+     * Throws std::invalid_argument if the kernel is empty, or if the separable method is requested
+     * for a kernel that is not separable.
+     *
+     * @param kernel_ Convolution kernel
+     * @param method_ Algorithm, chosen per image by default
+     */
+    explicit Convolution(const MatrixXd& kernel_, ConvolutionMethod method_ = ConvolutionMethod::Auto);
+
+    /**
+     * @brief Check if the kernel is separable (the product of a column and a row, up to rounding).
+     */
+    bool isSeparable() const;
+
+    /**
+     * @brief Algorithm used for an image of the given size: the requested one, or the cheapest
+     * according to the estimated number of operations of every algorithm.
+     *
+     * @param nrows number of rows of the image
+     * @param ncols number of columns of the image
+     * @return ConvolutionMethod Direct, Separable or FFT
+     */
+    ConvolutionMethod choose(int nrows, int ncols) const;
+
+    /**
+     * @brief Convolve an image with the kernel
+     *
+     * @param item Eigen matrix of the image
+     * @return MatrixXd Eigen matrix of the convolved image (same size)
+     */
+    MatrixXd transform(const MatrixXi& item) const override;
+
+    /**
+     * @brief Convolve an image with the kernel writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen matrix of the image
+     * @param out Eigen matrix of the convolved image (same size)
+     */
+    void transform(const MatrixXi& item, MatrixXd& out) const override;
+
+    /**
+     * @brief Convolve an image with the kernel with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix of the image
+     * @param out Eigen matrix of the convolved image (same size)
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const MatrixXi& item, MatrixXd& out, TransformWorkspace& workspace) const;
 };
 
 
 /**
  * @brief Lowpass filter using 2d Fourier trasnforms
- * 
+ *
+ * @tparam T Precision of the Fourier transforms (float or double).
+ * @tparam P Pixel type of the images (int, uint8_t or uint16_t).
  */
-class LowpassFilter : public Transform<MatrixXi,MatrixXi> {
+template <typename T = double, typename P = int>
+class LowpassFilter : public Transform<PixelMatrix<P>, PixelMatrix<P>> {
 private:
     double thr; /// threshold for the filter
     int stp; /// number of steps for the FFT
-    MatrixXi filtered; /// the filtered matrix
-    int transformed; /// flag if the transform has been applied
 
 public:
     /**
@@ -231,22 +1272,41 @@ public:
      * @brief Apply the low pass flter
      * 
      * @param item Eigen matrix before filtering
-     * @return MatrixXi Eigen matrix after filtering
+     * @return PixelMatrix<P> Eigen matrix after filtering
+     */
+    PixelMatrix<P> transform(const PixelMatrix<P>& item) const override;
+
+    /**
+     * @brief Apply the filter writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Eigen matrix after filtering
      */
-    MatrixXi transform(const MatrixXi& item) override;
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out) const override;
+
+    /**
+     * @brief Apply the filter with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Eigen matrix after filtering
+     * @param workspace Scratch memory, used by one thread at a time
+     */
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out, TransformWorkspace& workspace) const;
 };
 
 
 /**
  * @brief Highpass filter using 2d Fourier trasnforms
- * 
+ *
+ * @tparam T Precision of the Fourier transforms (float or double).
+ * @tparam P Pixel type of the images (int, uint8_t or uint16_t).
  */
-class HighpassFilter : public Transform<MatrixXi,MatrixXi> {
+template <typename T = double, typename P = int>
+class HighpassFilter : public Transform<PixelMatrix<P>, PixelMatrix<P>> {
 private:
     double thr; /// threshold for the filter
     int stp; /// number of steps for the FFT
-    MatrixXi filtered; /// the filtered matrix
-    int transformed; /// flag if the transform has been applied
 
 public:
     /**
@@ -261,9 +1321,27 @@ public:
      * @brief Apply the low pass flter
      * 
      * @param item Eigen matrix before filtering
-     * @return MatrixXi Eigen matrix after filtering
+     * @return PixelMatrix<P> Eigen matrix after filtering
+     */
+    PixelMatrix<P> transform(const PixelMatrix<P>& item) const override;
+
+    /**
+     * @brief Apply the filter writing into a preallocated output
+     * (reused without allocation if it has the right size).
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Eigen matrix after filtering
+     */
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out) const override;
+
+    /**
+     * @brief Apply the filter with the scratch memory of the caller.
+     *
+     * @param item Eigen matrix before filtering
+     * @param out Eigen matrix after filtering
+     * @param workspace Scratch memory, used by one thread at a time
      */
-    MatrixXi transform(const MatrixXi& item) override;
+    void transform(const PixelMatrix<P>& item, PixelMatrix<P>& out, TransformWorkspace& workspace) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -4,24 +4,28 @@
 
 /* Readers/writers for Eigen matrices */
 
-MatrixXi readIntMatrix(const string& inp_fname) {
+template <typename P>
+PixelMatrix<P> readIntMatrix(const string& inp_fname) {
     string extension(std::experimental::filesystem::path(inp_fname).extension());
 
     cout << inp_fname << " " << cv::haveImageReader(inp_fname) << "\n";
 
     if (cv::haveImageReader(inp_fname)) {
-        cv::Mat image = cv::imread(inp_fname, cv::IMREAD_GRAYSCALE);
-        return opencv2eigen(image);
+        /*16-bit pixels keep the depth of the file, the others are read as 8-bit grayscale*/
+        int flags = std::is_same<P, uint16_t>::value ? cv::IMREAD_ANYDEPTH : cv::IMREAD_GRAYSCALE;
+        cv::Mat image = cv::imread(inp_fname, flags);
+        return opencv2eigen<P>(image);
     } else {
         throw std::invalid_argument("Cannot read an integer matrix from " + inp_fname);
     }
     // todo: check if audio can be loaded as ints
 
-    MatrixXi tmp_inp_img;
+    PixelMatrix<P> tmp_inp_img;
     return tmp_inp_img;
 }
 
-void writeIntMatrix(const string& out_fname, const MatrixXi& matrix) {
+template <typename P>
+void writeIntMatrix(const string& out_fname, const PixelMatrix<P>& matrix) {
     bool result = true;
 
     if (cv::haveImageWriter(out_fname)) {
@@ -83,30 +87,139 @@ MatrixXd readFloatMatrix(const string& inp_fname) {
 
 /* Conversion of matrices between internal types */
 
-MatrixXi opencv2eigen(const cv::Mat& image) {
-    int n_cols = image.cols;
-    int n_rows = image.rows;
-    MatrixXi mat(n_rows, n_cols);
+/*the row-major images and the column-major matrices are converted by square tiles that stay in the L1 cache:
+  a tile is transposed in the narrower pixel type, and widened or narrowed one contiguous column at a time
+  (loops the compiler vectorizes), instead of accessing the image in column order*/
+static const int conversionTile = 64;
+
+/*image[rows x cols] (row-major, rows step elements apart) -> mat (column-major)*/
+template <typename S, typename D>
+static void rowsToColumns(const S* image, size_t step, int n_rows, int n_cols, D* mat) {
+    S tile[conversionTile * conversionTile];
+    for (int j0 = 0; j0 < n_cols; j0 += conversionTile) {
+        int nj = std::min(conversionTile, n_cols - j0);
+        for (int i0 = 0; i0 < n_rows; i0 += conversionTile) {
+            int ni = std::min(conversionTile, n_rows - i0);
+            for (int i = 0; i < ni; ++i) {
+                const S* row = image + (i0 + i) * step + j0;
+                for (int j = 0; j < nj; ++j) {
+                    tile[j * conversionTile + i] = row[j];
+                }
+            }
+            for (int j = 0; j < nj; ++j) {
+                D* column = mat + size_t(j0 + j) * n_rows + i0;
+                const S* pixels = tile + j * conversionTile;
+                for (int i = 0; i < ni; ++i) {
+                    column[i] = saturatePixel<D>(pixels[i]);
+                }
+            }
+        }
+    }
+}
 
-    for (int i = 0; i < n_cols; ++i) {
-        for (int j = 0; j < n_rows; ++j) {
-            mat(j, i) = (int) image.at<char>(j, i);
+/*mat (column-major) -> image[rows x cols] (row-major, rows step elements apart), with a saturating pack*/
+template <typename S, typename D>
+static void columnsToRows(const S* mat, int n_rows, int n_cols, D* image, size_t step) {
+    D tile[conversionTile * conversionTile];
+    for (int j0 = 0; j0 < n_cols; j0 += conversionTile) {
+        int nj = std::min(conversionTile, n_cols - j0);
+        for (int i0 = 0; i0 < n_rows; i0 += conversionTile) {
+            int ni = std::min(conversionTile, n_rows - i0);
+            for (int j = 0; j < nj; ++j) {
+                const S* column = mat + size_t(j0 + j) * n_rows + i0;
+                D* pixels = tile + j * conversionTile;
+                for (int i = 0; i < ni; ++i) {
+                    pixels[i] = saturatePixel<D>(column[i]);
+                }
+            }
+            for (int i = 0; i < ni; ++i) {
+                D* row = image + (i0 + i) * step + j0;
+                for (int j = 0; j < nj; ++j) {
+                    row[j] = tile[j * conversionTile + i];
+                }
+            }
         }
     }
+}
 
-    return mat;
+template <typename P>
+ConstImageView<P> opencvView(const cv::Mat& image) {
+    if (image.type() != cv::DataType<P>::type) {
+        throw std::invalid_argument("Expected a single-channel image of type " + std::to_string(cv::DataType<P>::type) +
+                                    ", got type " + std::to_string(image.type()));
+    }
+    return ConstImageView<P>(image.ptr<P>(), image.rows, image.cols, Eigen::OuterStride<>(image.step1()));
 }
 
-cv::Mat eigen2opencv(const MatrixXi& mat) {
-    int n_cols = mat.cols();
-    int n_rows = mat.rows();
-    cv::Mat image = cv::Mat::zeros(n_rows, n_cols, CV_8U);
+template <typename P>
+ImageView<P> opencvView(cv::Mat& image) {
+    if (image.type() != cv::DataType<P>::type) {
+        throw std::invalid_argument("Expected a single-channel image of type " + std::to_string(cv::DataType<P>::type) +
+                                    ", got type " + std::to_string(image.type()));
+    }
+    return ImageView<P>(image.ptr<P>(), image.rows, image.cols, Eigen::OuterStride<>(image.step1()));
+}
 
-    for (int i = 0; i < n_cols; ++i) {
-        for (int j = 0; j < n_rows; ++j) {
-            image.at<char>(j, i) = mat(j, i);
-        }
+template <typename P>
+PixelMatrix<P> opencv2eigen(const cv::Mat& image) {
+    PixelMatrix<P> mat;
+    opencv2eigen(image, mat);
+    return mat;
+}
+
+template <typename P>
+void opencv2eigen(const cv::Mat& image, PixelMatrix<P>& mat) {
+    mat.resize(image.rows, image.cols);
+    if (image.depth() == CV_16U) {
+        ConstImageView<ushort> view = opencvView<ushort>(image);
+        rowsToColumns(view.data(), view.outerStride(), view.rows(), view.cols(), mat.data());
+    } else {
+        ConstImageView<uchar> view = opencvView<uchar>(image);
+        rowsToColumns(view.data(), view.outerStride(), view.rows(), view.cols(), mat.data());
     }
+}
 
+template <typename P>
+cv::Mat eigen2opencv(const PixelMatrix<P>& mat) {
+    cv::Mat image;
+    eigen2opencv(mat, image);
     return image;
 }
+
+template <typename P>
+void eigen2opencv(const PixelMatrix<P>& mat, cv::Mat& image) {
+    if constexpr (std::is_same<P, uint16_t>::value) {
+        image.create(mat.rows(), mat.cols(), CV_16U);
+        ImageView<ushort> view = opencvView<ushort>(image);
+        columnsToRows(mat.data(), mat.rows(), mat.cols(), view.data(), view.outerStride());
+    } else {
+        image.create(mat.rows(), mat.cols(), CV_8U);
+        ImageView<uchar> view = opencvView<uchar>(image);
+        columnsToRows(mat.data(), mat.rows(), mat.cols(), view.data(), view.outerStride());
+    }
+}
+
+
+/*the readers, writers and conversions are compiled for int, 8-bit and 16-bit pixels*/
+template PixelMatrix<int> readIntMatrix(const string& inp_fname);
+template PixelMatrix<uint8_t> readIntMatrix(const string& inp_fname);
+template PixelMatrix<uint16_t> readIntMatrix(const string& inp_fname);
+template void writeIntMatrix(const string& out_fname, const PixelMatrix<int>& matrix);
+template void writeIntMatrix(const string& out_fname, const PixelMatrix<uint8_t>& matrix);
+template void writeIntMatrix(const string& out_fname, const PixelMatrix<uint16_t>& matrix);
+template ConstImageView<uchar> opencvView(const cv::Mat& image);
+template ConstImageView<ushort> opencvView(const cv::Mat& image);
+template ImageView<uchar> opencvView(cv::Mat& image);
+template ImageView<ushort> opencvView(cv::Mat& image);
+template PixelMatrix<int> opencv2eigen(const cv::Mat& image);
+template PixelMatrix<uint8_t> opencv2eigen(const cv::Mat& image);
+template PixelMatrix<uint16_t> opencv2eigen(const cv::Mat& image);
+template void opencv2eigen(const cv::Mat& image, PixelMatrix<int>& mat);
+template void opencv2eigen(const cv::Mat& image, PixelMatrix<uint8_t>& mat);
+template void opencv2eigen(const cv::Mat& image, PixelMatrix<uint16_t>& mat);
+template cv::Mat eigen2opencv(const PixelMatrix<int>& mat);
+template cv::Mat eigen2opencv(const PixelMatrix<uint8_t>& mat);
+template cv::Mat eigen2opencv(const PixelMatrix<uint16_t>& mat);
+template void eigen2opencv(const PixelMatrix<int>& mat, cv::Mat& image);
+template void eigen2opencv(const PixelMatrix<uint8_t>& mat, cv::Mat& image);
+template void eigen2opencv(const PixelMatrix<uint16_t>& mat, cv::Mat& image);
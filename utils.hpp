@@ -7,6 +7,7 @@
 #include "Eigen/Dense"
 #include "AudioFile.h"
 #include <opencv2/opencv.hpp>
+#include "transforms.hpp"
 
 using std::cout;
 using std::string;
@@ -15,23 +16,27 @@ using Eigen::MatrixXd;
 
 /**
  * @brief Read integer matrix from a file.
- * Supported formats: image (e.g. png and tiff).
+ * Supported formats: image (e.g. png and tiff), read as 8-bit grayscale, or with its 16-bit depth for uint16_t pixels.
  * 
+ * @tparam P Pixel type (int, uint8_t or uint16_t).
  * @param inp_fname Input filename. 
- * @return MatrixXi Read matrix.
+ * @return PixelMatrix<P> Read matrix.
  */
-MatrixXi readIntMatrix(const string& inp_fname);
+template <typename P = int>
+PixelMatrix<P> readIntMatrix(const string& inp_fname);
 
 // todo: Eigen::Matrix<std::complex<double>,-1, -1> readComplexMatrix(const string& inp_fname);
 
 /**
  * @brief Save integer matrix in a file.
- * Supported formats: image (e.g. png and tiff).
+ * Supported formats: image (e.g. png and tiff), saved as 8-bit grayscale, or 16-bit for uint16_t pixels.
  * 
+ * @tparam P Pixel type (int, uint8_t or uint16_t).
  * @param out_fname 
  * @param matrix 
  */
-void writeIntMatrix(const string& out_fname, const MatrixXi& matrix);
+template <typename P>
+void writeIntMatrix(const string& out_fname, const PixelMatrix<P>& matrix);
 
 /**
  * @brief Save double matrix in a file.
@@ -53,19 +58,87 @@ void writeComplexMatrix(const string& out_fname, const Eigen::Matrix<std::comple
 
 MatrixXd readFloatMatrix(const string& inp_fname);
 
+/**
+ * @brief Row-major matrix of pixels, the layout of a grayscale opencv image.
+ *
+ * @tparam P Pixel type (uchar or ushort).
+ */
+template <typename P = uchar>
+using ImageRows = Eigen::Matrix<P, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+/**
+ * @brief Zero-copy view of a grayscale opencv image (its rows may be padded, e.g. a region of interest).
+ */
+template <typename P = uchar>
+using ConstImageView = Eigen::Map<const ImageRows<P>, 0, Eigen::OuterStride<>>;
+
+/**
+ * @brief Writable zero-copy view of a grayscale opencv image.
+ */
+template <typename P = uchar>
+using ImageView = Eigen::Map<ImageRows<P>, 0, Eigen::OuterStride<>>;
+
+/**
+ * @brief View a single-channel opencv matrix as an eigen matrix, without copy.
+ * Throws std::invalid_argument if the pixels of the image are not of type P.
+ * 
+ * @tparam P Pixel type (uchar for CV_8U, ushort for CV_16U).
+ * @param image Matrix in the opencv format (must outlive the view).
+ * @return ConstImageView<P> Eigen view of the pixels.
+ */
+template <typename P = uchar>
+ConstImageView<P> opencvView(const cv::Mat& image);
+
+/**
+ * @brief View a single-channel opencv matrix as a writable eigen matrix, without copy.
+ * Throws std::invalid_argument if the pixels of the image are not of type P.
+ * 
+ * @tparam P Pixel type (uchar for CV_8U, ushort for CV_16U).
+ * @param image Matrix in the opencv format (must outlive the view).
+ * @return ImageView<P> Eigen view of the pixels.
+ */
+template <typename P = uchar>
+ImageView<P> opencvView(cv::Mat& image);
+
 /**
  * @brief Convert opencv matrix to eigen integer matrix.
+ * Throws std::invalid_argument if the image is not 8-bit or 16-bit single-channel.
+ * 
+ * @tparam P Pixel type of the eigen matrix (int, uint8_t or uint16_t), values out of its range are saturated.
+ * @param image Matrix in the opencv format.
+ * @return PixelMatrix<P> Integer matrix in the eigen format.
+ */
+template <typename P = int>
+PixelMatrix<P> opencv2eigen(const cv::Mat& image);
+
+/**
+ * @brief Convert opencv matrix to eigen integer matrix, writing into a preallocated matrix
+ * (reused without allocation if it has the right size).
  * 
  * @param image Matrix in the opencv format.
- * @return MatrixXi Integer matrix in the eigen format.
+ * @param mat Integer matrix in the eigen format.
  */
-MatrixXi opencv2eigen(const cv::Mat& image);
+template <typename P>
+void opencv2eigen(const cv::Mat& image, PixelMatrix<P>& mat);
 
 /**
- * @brief Convert eigen matrix to opencv matrix.
+ * @brief Convert eigen matrix to opencv matrix (CV_16U for uint16_t pixels, CV_8U otherwise).
+ * The coefficients are saturated to the range of the opencv pixels.
  * 
  * @param mat Integer matrix in the eigen format.
  * @return cv::Mat Matrix in the opencv format.
  */
-cv::Mat eigen2opencv(const MatrixXi& mat);
+template <typename P>
+cv::Mat eigen2opencv(const PixelMatrix<P>& mat);
+
+/**
+ * @brief Convert eigen matrix to opencv matrix, writing into the buffer of an existing image
+ * (reallocated by cv::Mat::create only if it has another size or type).
+ * The coefficients are saturated to the range of the opencv pixels.
+ * 
+ * @param mat Integer matrix in the eigen format.
+ * @param image Matrix in the opencv format.
+ */
+template <typename P>
+void eigen2opencv(const PixelMatrix<P>& mat, cv::Mat& image);
 #endif
\ No newline at end of file